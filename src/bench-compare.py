@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+# * Comparaison de deux constructions
+#
+# Lance les micro- et macrobenchmarks de deux constructions
+# (répertoires contenant microbench et macrobench.py) ou
+# relit des résultats enregistrés, puis compare chaque mesure.
+#
+# Chaque mesure est répétée (-r) pour obtenir un
+# échantillon de temps. La comparaison se fait sur le
+# logarithme des temps par un test de Welch : le rapport
+# B/A des moyennes géométriques est donné avec son
+# intervalle de confiance au niveau 1 - alpha. Une mesure
+# est une régression si l'intervalle est tout entier
+# au-dessus de 1 et le rapport au-delà du seuil (-t, en %).
+# Le code de sortie est alors 1.
+#
+# Usage
+#   ./bench-compare.py [options] A B     compare A et B
+#   ./bench-compare.py [options] -s F A  enregistre A dans F
+#
+# A et B sont des répertoires de construction ou des
+# fichiers de résultats (CSV suite,bench,value, une ligne
+# par essai, temps en ns/op ou en secondes).
+
+import argparse
+import csv
+import math
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+DATA = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'data')
+
+
+# ** Collecte des échantillons
+
+def run_micro(build, repeat, seconds, samples):
+    for _ in range(repeat):
+        out = subprocess.run([os.path.join(build, 'microbench'), DATA, str(seconds)],
+                             capture_output=True, text=True, check=True).stdout
+        for r in csv.DictReader(out.splitlines()):
+            key = '%s/%s/q%s' % (r['kernel'], r['isa'], r['q'])
+            samples.setdefault(('micro', key), []).append(float(r['ns_per_op']))
+
+
+def run_macro(build, repeat, filt, samples):
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, 'macro.csv')
+        for _ in range(repeat):
+            subprocess.run([sys.executable, os.path.join(build, 'macrobench.py'),
+                            '-t', '1', '-o', out, filt],
+                           stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                           check=True)
+            with open(out) as f:
+                for r in csv.DictReader(f):
+                    key = '%s/%s/n%s/%s' % (r['program'], r['constellation'],
+                                            r['n'], r['param'])
+                    samples.setdefault(('macro', key), []).append(float(r['wall_s']))
+
+
+def collect(src, a):
+    samples = {}
+    if os.path.isdir(src):
+        if a.suite in ('all', 'micro'):
+            run_micro(src, a.repeat, a.seconds, samples)
+        if a.suite in ('all', 'macro'):
+            run_macro(src, a.repeat, a.filter, samples)
+    else:
+        with open(src) as f:
+            for r in csv.DictReader(f):
+                samples.setdefault((r['suite'], r['bench']), []).append(float(r['value']))
+    return samples
+
+
+def save(samples, path):
+    with open(path, 'w', newline='') as f:
+        w = csv.writer(f)
+        w.writerow(['suite', 'bench', 'value'])
+        for (suite, bench), values in samples.items():
+            for v in values:
+                w.writerow([suite, bench, repr(v)])
+
+
+# ** Statistiques
+
+def t_quantile(p, nu):
+    """Quantile de la loi de Student à nu degrés de liberté,
+    par le développement de Cornish-Fisher autour de la loi
+    normale (erreur < 1e-3 dès nu = 3)."""
+    z = statistics.NormalDist().inv_cdf(p)
+    if math.isinf(nu):
+        return z
+    return (z + (z**3 + z) / (4 * nu)
+            + (5 * z**5 + 16 * z**3 + 3 * z) / (96 * nu**2)
+            + (3 * z**7 + 19 * z**5 + 17 * z**3 - 15 * z) / (384 * nu**3)
+            + (79 * z**9 + 776 * z**7 + 1482 * z**5 - 1920 * z**3 - 945 * z)
+            / (92160 * nu**4))
+
+
+def welch(a, b, alpha):
+    """Rapport des moyennes géométriques de b et a et son
+    intervalle de confiance."""
+    la = [math.log(v) for v in a]
+    lb = [math.log(v) for v in b]
+    d = statistics.fmean(lb) - statistics.fmean(la)
+    if len(a) < 2 or len(b) < 2:
+        return math.exp(d), 0.0, math.inf
+    va = statistics.variance(la) / len(la)
+    vb = statistics.variance(lb) / len(lb)
+    se = math.sqrt(va + vb)
+    if se == 0:
+        return math.exp(d), math.exp(d), math.exp(d)
+    nu = (va + vb) ** 2 / (va**2 / (len(la) - 1) + vb**2 / (len(lb) - 1))
+    t = t_quantile(1 - alpha / 2, nu)
+    return math.exp(d), math.exp(d - t * se), math.exp(d + t * se)
+
+
+# ** Rapport
+
+def compare(A, B, a):
+    heads = ['suite', 'mesure', 'A', 'B', 'B/A', 'IC', 'verdict']
+    rows = []
+    regressions = 0
+    limit = 1 + a.threshold / 100
+    for key in sorted(set(A) & set(B)):
+        ratio, lo, hi = welch(A[key], B[key], a.alpha)
+        if lo > 1 and ratio > limit:
+            verdict = 'RÉGRESSION'
+            regressions += 1
+        elif lo > 1:
+            verdict = 'plus lent'
+        elif hi < 1:
+            verdict = 'plus rapide'
+        else:
+            verdict = '~'
+        rows.append([key[0], key[1],
+                     '%.4g' % statistics.median(A[key]),
+                     '%.4g' % statistics.median(B[key]),
+                     '%.3f' % ratio, '[%.3f, %.3f]' % (lo, hi), verdict])
+
+    widths = [max(len(c) for c in col) for col in zip(heads, *rows)]
+    line = lambda cs: '| ' + ' | '.join(c.ljust(w) for c, w in zip(cs, widths)) + ' |'
+    print(line(heads))
+    print('|' + '+'.join('-' * (w + 2) for w in widths) + '|')
+    for r in rows:
+        print(line(r))
+    for key in sorted(set(A) ^ set(B)):
+        print('absent de %s : %s/%s' % ('B' if key in A else 'A', *key), file=sys.stderr)
+    print('%d régression(s) au-delà de %.1f%% (alpha = %g)'
+          % (regressions, a.threshold, a.alpha))
+    return regressions
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Comparaison des benchmarks de deux constructions')
+    ap.add_argument('builds', nargs='+', help='répertoires ou fichiers de résultats')
+    ap.add_argument('-s', '--save', help='enregistre les échantillons du premier argument')
+    ap.add_argument('-r', '--repeat', type=int, default=5, help='essais par mesure')
+    ap.add_argument('-t', '--threshold', type=float, default=5.0,
+                    help='ralentissement toléré, en %%')
+    ap.add_argument('-a', '--alpha', type=float, default=0.05,
+                    help='risque du test (intervalles à 1 - alpha)')
+    ap.add_argument('--suite', choices=['all', 'micro', 'macro'], default='all')
+    ap.add_argument('--seconds', type=float, default=0.05,
+                    help='durée minimale de chaque microbenchmark')
+    ap.add_argument('--filter', default='', help='filtre des macrobenchmarks')
+    a = ap.parse_args()
+
+    if a.save:
+        if len(a.builds) != 1:
+            ap.error('-s attend un seul répertoire')
+        save(collect(a.builds[0], a), a.save)
+        return 0
+    if len(a.builds) != 2:
+        ap.error('il faut deux constructions A et B')
+
+    A = collect(a.builds[0], a)
+    B = collect(a.builds[1], a)
+    return 1 if compare(A, B, a) else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
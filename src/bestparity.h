@@ -0,0 +1,1006 @@
+/* * libbestparity
+ *
+ * Bibliothèque commune aux programmes best-parity, crible
+ * et spectra : corps finis GF(2^m), lecture des
+ * constellations, mappings et parités, tables de
+ * quadrances et de voisinages, itérateurs sur les parités
+ * et les mots de code, comparaison de spectres et
+ * évaluation par lots.
+ *
+ * L'API reste en C pur pour pouvoir être appelée aussi bien
+ * depuis un programme C que C++.
+ */
+
+#ifndef BESTPARITY_H
+#define BESTPARITY_H
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define error(format, ...)                                                 \
+  do {                                                                     \
+    fflush (stdout);                                                       \
+    fprintf (stderr, "%s:%d: " format, __FILE__, __LINE__, ##__VA_ARGS__); \
+    fprintf (stderr, "\n");                                                \
+    exit (EXIT_FAILURE);                                                   \
+  } while (0)
+
+
+/* * Bibliothèque GF(2^m)
+ *
+ * Bibliothèque pour les corps finis GF(q) avec q=2^m. Les
+ * éléments du corps sont représentés par des entiers de
+ * 0 à q-1.
+ *
+ * Comme la caractéristique est 2, l'addition est le ou
+ * exclusif.
+ *
+ * Pour la multiplication, on utilise une table de
+ * logarithme sur la base d'un élément primitif. Seule cette
+ * table est nécessaire pour construire le corps complet.
+ *
+ * Pour éviter de se trimbaler sans cesse la représentation
+ * du corps, on fait appel à des variables globales. Il
+ * n'est donc possible de travailler qu'avec un corps à la
+ * fois.
+ *
+ * La liste des polynômes primitifs utilisés se trouve dans
+ * gf.c.
+ */
+
+extern const size_t max_degree;    /* primitives[m] pour m <= max_degree */
+extern const unsigned primitives[];
+
+
+/* ** Types */
+
+/* Un élément de GF(q) est représenté par un entier non
+   signé entre 0 et q-1, sur 16 bits (m <= 16). Une boucle
+   sur tout le corps doit donc avoir un compteur plus large
+   que gf_elt. */
+typedef uint16_t gf_elt;
+
+
+/* ** Constantes */
+
+/* Quelques constantes sur le corps fini. */
+extern size_t gf_size;          // Taille du corps
+extern size_t gf_size_minus_1;  // Taille du corps moins un
+extern size_t gf_degree;        // Degré: 2^deg = size
+extern const gf_elt gf_zero;    // Le zéro
+extern const gf_elt gf_one;     // Le un
+extern gf_elt gf_alpha;         // Un élément primitif
+
+
+/* La table des logarithmes: un élément non nul $x$ de GF(q)
+   s'écrit comme une puissance $\alpha^k$ d'un élément
+   primitif $\alpha$. Cette table indicée par $x$ retourne
+   la puissance $k$ correspondante. Pour 0, elle
+   retourne -1. La table gf_exp fait l'inverse, elle
+   retourne $\alpha^k$ à partir de l'indice $k$. */
+extern int *gf_log;
+extern gf_elt *gf_exp;
+
+
+/* Pour m = 8 seulement, l'isomorphisme phi de GF(256)
+   construit sur 0x11d vers GF(256) construit sur le
+   polynôme de l'AES 0x11b, utilisé par les instructions
+   GFNI, et son inverse. NULL pour les autres corps. */
+extern uint8_t *gf_to_aes;
+extern uint8_t *gf_from_aes;
+
+
+/* ** Opérations algébriques */
+
+/* Calcul acc <- acc + \alpha^hlog * x. hlog doit être entre
+   0 et gf_size_minus_1 exclu. */
+static inline void gf_accmul(gf_elt *acc, int hlog, gf_elt x) {
+  if (x == gf_zero) return;
+  *acc ^= gf_exp[(hlog + gf_log[x]) % gf_size_minus_1];
+}
+
+
+/* ** Initialisation et libération */
+
+/* Initialisation du corps fini GF(q) à partir d'un polynôme
+   primitif P donné par sa représentation binaire. */
+int gf_init(unsigned P);
+
+/* Libération des ressources utilisées par le corps */
+int gf_free(void);
+
+
+/* * Noyaux de calcul
+ *
+ * Les boucles les plus chaudes travaillent sur des lots de
+ * symboles rangés par colonnes : un tableau par position du
+ * mot, un octet par symbole. Elles ne servent donc que pour
+ * m <= 8.
+ *
+ * Chaque noyau est compilé en plusieurs variantes (scalar,
+ * sse4.2, avx2, avx512, gfni). La meilleure variante
+ * supportée par le processeur est choisie une fois pour
+ * toutes par gf_init, sauf si la variable d'environnement
+ * BESTPARITY_ISA en impose une autre.
+ */
+
+/* Taille des lots manipulés par les noyaux */
+#define KERN_BLOCK 64
+
+
+/* Multiplication par une constante \alpha^hlog, préparée
+   pour les différentes variantes : tables des produits par
+   les quartets bas et haut (pshufb) et matrice 8x8 de
+   l'application GF(2)-linéaire (gf2p8affineqb). */
+struct gf_mul {
+  uint8_t lo[16];
+  uint8_t hi[16];
+  uint64_t affine;
+  uint8_t aes;               /* phi(\alpha^hlog), pour m = 8 */
+};
+
+
+/* Prépare la multiplication par \alpha^hlog. */
+void gf_mul_init(struct gf_mul *c, int hlog);
+
+
+struct kernels {
+  const char *name;
+  bool aes;                  /* Symboles dans la base de l'AES (m = 8) */
+
+  /* acc[k] <- acc[k] + c * x[k] pour k < len */
+  void (*mulacc)(uint8_t *acc, const struct gf_mul *c,
+                 const uint8_t *x, size_t len);
+
+  /* s[k] <- Y[n-1][k] + sum_{i<n-1} h[i] * Y[i][k] pour k <
+     count, la colonne i commençant en Y + i * stride. s[k]
+     est nul si et seulement si le k-ème vecteur vérifie la
+     parité. */
+  void (*syndromes)(size_t n, const struct gf_mul *h,
+                    const uint8_t *Y, size_t stride,
+                    size_t count, uint8_t *s);
+
+  /* Pour k < count, t = T[e[k]], acc[k] <- acc[k] + (t &
+     0xffffff) et y[k] <- t >> 24. T range dans chaque mot
+     une quadrance et le symbole correspondant. */
+  void (*quadacc)(unsigned *acc, uint8_t *y, const uint32_t *T,
+                  const uint16_t *e, size_t count);
+
+  /* Comparaison de spectres, cf. sp_cmp. */
+  int (*spcmp)(const unsigned long *a, const unsigned long *b,
+               unsigned qmax);
+
+  /* Crible de KERN_LANES parités à la fois, une par octet :
+     pour j < count, y = base ^ T + c[j] * KERN_LANES, et
+     cnt[l] augmente de 1 si y[l] vaut l'un des
+     tgt[k * KERN_LANES + l], k < ntgt, dont le masque msk
+     est non nul. Au plus 255 voisins par appel. */
+  void (*lanes)(const uint8_t *base, const uint8_t *T, const gf_elt *c,
+                size_t count, const uint8_t *tgt, const uint8_t *msk,
+                size_t ntgt, uint8_t *cnt);
+
+  /* Syndromes en tranches de bits, pour m <= 4 et count <=
+     KERN_BLOCK voisins rangés comme pour syndromes : le bit
+     k du mot j porte le bit j du symbole du voisin k, et la
+     multiplication par h[i] est le réseau de ou exclusifs
+     donné par sa matrice (h[i].affine). Retourne le masque
+     des voisins de syndrome nul. */
+  uint64_t (*sliced)(size_t n, const struct gf_mul *h,
+                     const uint8_t *Y, size_t stride, size_t count);
+};
+
+/* Parités traitées ensemble par le noyau lanes */
+#define KERN_LANES 32
+
+/* Variante choisie */
+extern const struct kernels *kern;
+
+/* Choisit la variante des noyaux. name vaut NULL pour
+   laisser faire la détection du processeur. */
+const struct kernels *kern_init(const char *name);
+
+/* Nombre maximal de variantes */
+#define KERN_VARIANTS 8
+
+/* Range dans names les noms des variantes supportées par le
+   processeur, par ordre de préférence, et retourne leur
+   nombre (au plus KERN_VARIANTS). */
+size_t kern_list(const char **names);
+
+
+/* Symbole x tel que le voient les noyaux : x lui-même, ou
+   phi(x) si la variante travaille dans la base de l'AES. Les
+   tables données aux noyaux sont converties une fois pour
+   toutes au chargement. */
+static inline uint8_t kern_sym(gf_elt x) {
+  return kern->aes ? gf_to_aes[x] : x;
+}
+
+
+/* * Parity check
+ *
+ * Il faudra itérer sur les différentes parités de taille
+ * n donnée. Pour des raisons évidentes de symétrie, il
+ * n'est pas nécessaire de faire le tour des (q-1)^n parités
+ * dont aucun coefficient n'est nul, mais il suffit de
+ * regarder les multi-ensembles ce qui donne ((q-1
+ * multichoose n)) = (q-1+n-1 choose n) possibilités. À cela
+ * s'ajoute aussi qu'un coefficient peut toujours être mis
+ * à 1. Le dernier jouera ce rôle ici.
+ *
+ * Une parité h est stockée par les logarithmes de ses
+ * coefficients.
+ */
+
+/* Indique si une parité h de longueur n est vérifiée par le
+   vecteur x. */
+static inline bool chk_valid(size_t n, const gf_elt *h, const gf_elt *x) {
+  gf_elt acc = gf_zero;
+  for (size_t i = 0; i < n-1; ++i)
+    gf_accmul(&acc, *h++, *x++);
+  return acc == *x;
+}
+
+
+/* Initialise un itérateur sur les parités remplissant h. */
+static inline void chk_begin(size_t n, gf_elt *h) {
+  for (size_t i = 0; i < n-1; ++i)
+    h[i] = n-i-1;
+  h[n-1] = 0;
+}
+
+
+/* Passe à la parité suivante */
+static inline bool chk_next(size_t n, gf_elt *h) {
+  size_t i;
+  for (i = 0; h[i] >= gf_size_minus_1 - i - 1; ++i)
+    if (i + 3 > n)
+      return false;
+  for (h[i]++; i; i--)
+    h[i-1] = h[i] + 1;
+  return true;
+}
+
+
+/* Nombre de parités parcourues par chk_begin/chk_next :
+   h0 > h1 > ... > h_{n-2} > 0 pris dans [1, q-2], soit
+   C(q-2, n-1). */
+static inline unsigned long long chk_count(size_t n) {
+  unsigned long long c = 1;
+  for (size_t i = 0; i < n-1; ++i)
+    c = c * (gf_size - 2 - i) / (i + 1);
+  return c;
+}
+
+
+/* Lit une parité h de longueur n sur f et la remet sous la
+   forme h0 >= h1 >= ... >= 0. Retourne false en fin de
+   fichier. */
+bool chk_read(FILE *f, size_t n, gf_elt *h);
+
+
+/* ** Forme canonique
+ *
+ * Parités équivalentes (même spectre) à permutation des
+ * positions, multiplication par un scalaire et, en option,
+ * automorphismes du mapping près (cf. canon.c).
+ */
+
+struct chk_group {
+  unsigned nfrob;            /* Frobenius admissibles, l'identité comprise */
+  unsigned frob[32];         /* ... en multiplicateurs des logarithmes */
+  unsigned d;                /* Décalage libre de chaque position, divise q-1 */
+};
+
+struct mapping;
+
+/* Calcule le groupe de M : identité et scalaires seulement
+   si autos est faux. */
+void chk_group_init(struct chk_group *G, const struct mapping *M, bool autos);
+
+/* Forme canonique c de la parité h de longueur n. */
+void chk_canon(size_t n, const gf_elt *h, const struct chk_group *G, gf_elt *c);
+
+/* Ensemble de parités de longueur n */
+struct chk_set {
+  size_t n, len, size;
+  gf_elt *keys;              /* len clés de n coefficients */
+  size_t *slots;             /* Table de hachage, SIZE_MAX si libre */
+};
+
+void chk_set_init(struct chk_set *S, size_t n);
+
+/* Ajoute h s'il est absent ; retourne son rang d'insertion. */
+size_t chk_set_add(struct chk_set *S, const gf_elt *h);
+
+void chk_set_free(struct chk_set *S);
+
+
+/* * Mots de code */
+
+/* Initialise un itérateur dans x sur les mots de codes de
+   la parité h. */
+static inline void cw_begin(size_t n, const gf_elt *h, gf_elt *x) {
+  for (size_t i = 0; i < n; ++i)
+    x[i] = gf_zero;
+}
+
+
+/* Passe au mot de code suivant x de la parité h et retourne
+   false si plus aucun mot de code n'est obtenable. On
+   utilise le fait ici que le dernier coefficient de h est
+   1. */
+static inline bool cw_next(size_t n, const gf_elt *h, gf_elt *x) {
+  size_t i = 0;
+  for (i = 0; i < n-1; ++i)
+    if (x[i] == gf_size_minus_1)
+      x[i] = gf_zero;
+    else
+      break;
+  if (i == n-1) return false;
+  x[i]++;
+
+  gf_elt acc = gf_zero;
+  for (i = 0; i < n-1; ++i)
+    gf_accmul(&acc, h[i], x[i]);
+  x[n-1] = acc;
+  return true;
+}
+
+
+/* * Matrices de parité
+ *
+ * Un code de longueur n à r parités, de rendement (n-r)/n,
+ * est donné par sa matrice de parité sous forme
+ * systématique H = [A | I_r] : les k = n-r premières
+ * positions portent l'information, la position k+j la
+ * j-ème parité. La ligne j est stockée comme une parité de
+ * longueur k+1 sur les positions 0..k-1 et k+j, soit les
+ * logarithmes de A_j suivis de 0 : H occupe r(k+1) entiers
+ * et, pour r = 1, c'est la parité h habituelle.
+ *
+ * Les opérations sur les lignes ramènent tout code à cette
+ * forme. Une permutation des positions d'information trie
+ * la première ligne comme une parité (cf. chk_next) et les
+ * lignes suivantes, qui s'échangent librement avec leurs
+ * positions de parité, sont rangées par ordre
+ * lexicographique strictement décroissant. Les coefficients
+ * de A sont non nuls.
+ */
+
+/* Nombre d'entiers d'une matrice H à r parités. */
+static inline size_t pcm_size(size_t n, size_t r) {
+  return r * (n - r + 1);
+}
+
+
+/* Lignes 1..r-1 de la première matrice : la ligne j vaut
+   r-1-j en base q-1. */
+static inline void pcm_rows_begin(size_t n, size_t r, gf_elt *H) {
+  const size_t k = n - r;
+  for (size_t j = 1; j < r; ++j) {
+    gf_elt *Hj = H + j * (k + 1);
+    for (size_t i = 0; i <= k; ++i) Hj[i] = 0;
+    Hj[k-1] = r - 1 - j;
+  }
+}
+
+
+/* Initialise un itérateur sur les matrices à r parités
+   (r <= q) remplissant H. */
+static inline void pcm_begin(size_t n, size_t r, gf_elt *H) {
+  chk_begin(n - r + 1, H);
+  pcm_rows_begin(n, r, H);
+}
+
+
+/* Passe à la matrice suivante. Les lignes 1..r-1 forment
+   un odomètre (la dernière en poids faible) dont les
+   états qui ne sont pas strictement décroissants sont
+   sautés ; à son retour à zéro, la première ligne avance
+   par chk_next. Pour r = 1, c'est chk_next. */
+static inline bool pcm_next(size_t n, size_t r, gf_elt *H) {
+  const size_t k = n - r;
+  for (;;) {
+    size_t p = r * (k + 1) - 1;
+    for (; p > k; --p) {
+      if (p % (k + 1) == k) continue;
+      if (H[p] < gf_size_minus_1 - 1) break;
+      H[p] = 0;
+    }
+    if (p == k) {
+      pcm_rows_begin(n, r, H);
+      return chk_next(k + 1, H);
+    }
+    H[p]++;
+
+    size_t j = 2;
+    for (; j < r; ++j) {
+      const gf_elt *a = H + (j - 1) * (k + 1), *b = a + k + 1;
+      size_t i = 0;
+      while (i < k && a[i] == b[i]) ++i;
+      if (i == k || a[i] < b[i]) break;
+    }
+    if (j == r) return true;
+  }
+}
+
+
+/* Nombre de matrices parcourues par pcm_begin/pcm_next :
+   C(q-2, k) premières lignes fois C((q-1)^k, r-1) choix
+   des suivantes, ou 0 s'il dépasse 64 bits. */
+static inline unsigned long long pcm_count(size_t n, size_t r) {
+  const size_t k = n - r;
+  unsigned long long N = 1, c = chk_count(k + 1), t;
+  for (size_t i = 0; i < k; ++i)
+    if (__builtin_mul_overflow(N, gf_size_minus_1, &N)) return 0;
+  for (size_t j = 0; j < r - 1; ++j) {
+    if (__builtin_mul_overflow(c, N - j, &t)) return 0;
+    c = t / (j + 1);
+  }
+  return c;
+}
+
+
+/* Mot de code suivant x de la matrice H : les k symboles
+   d'information avancent comme pour cw_next, puis chaque
+   ligne donne son symbole de parité. */
+static inline bool pcm_cw_next(size_t n, size_t r, const gf_elt *H, gf_elt *x) {
+  const size_t k = n - r;
+  size_t i;
+  for (i = 0; i < k; ++i)
+    if (x[i] == gf_size_minus_1)
+      x[i] = gf_zero;
+    else
+      break;
+  if (i == k) return false;
+  x[i]++;
+
+  for (size_t j = 0; j < r; ++j, H += k + 1) {
+    gf_elt acc = gf_zero;
+    for (i = 0; i < k; ++i)
+      gf_accmul(&acc, H[i], x[i]);
+    x[k + j] = acc;
+  }
+  return true;
+}
+
+
+/* * Spectre
+ *
+ *  Le spectre est un tableau S tel que S[q] est la
+ *  multiplicité de la quadrance q. q est limité par qmax.
+ */
+
+/* Compare deux spectres. Le plus grand le meilleure. */
+static inline int sp_cmp(const unsigned long *a, const unsigned long *b, unsigned qmax) {
+  return kern->spcmp(a, b, qmax);
+}
+
+
+/* ** Spectres compressés
+ *
+ * Lignes creuses (rang, parité, couples quadrance et
+ * multiplicité non nulle) dans le format binaire décrit
+ * dans spio.c.
+ */
+
+struct sp_writer {
+  FILE *f;
+  size_t n;
+  unsigned long long next;   /* Rang suivant la dernière ligne */
+};
+
+/* Écrit l'en-tête sur f. */
+void sp_wopen(struct sp_writer *W, FILE *f, size_t n, unsigned qmax);
+
+/* Écrit la ligne de rang rank, supérieur aux précédents :
+   la parité h et les k quadrances quad, croissantes, de
+   multiplicités mult non nulles. */
+void sp_write(struct sp_writer *W, unsigned long long rank, const gf_elt *h,
+              size_t k, const unsigned *quad, const unsigned long long *mult);
+
+struct sp_reader {
+  FILE *f;
+  size_t n;
+  unsigned qmax;
+  unsigned long long rank, next;
+  gf_elt *h;                 /* Ligne courante */
+  size_t k;
+  unsigned *quad;
+  unsigned long long *mult;
+};
+
+/* Lit l'en-tête sur f ; retourne false si ce n'est pas un
+   fichier de spectres. */
+bool sp_ropen(struct sp_reader *R, FILE *f);
+
+/* Lit la ligne suivante ; retourne false en fin de fichier. */
+bool sp_read(struct sp_reader *R);
+
+void sp_rclose(struct sp_reader *R);
+
+
+/* * Bibliothèque de combinatoire */
+
+/* Retourne la représentation binaire du sous ensemble qui
+   suit celle de b selon l'algorithme de banker. */
+unsigned long banker(unsigned long b, int length);
+
+/* Permutation suivante de p dans l'ordre lexicographique.
+   Retourne 0 si c'est la dernière. */
+int permnext(int n, int *p);
+
+/* Composition suivante de quad en n parts p[0] + ... +
+   p[n-1] dont chacune d est admissible (ok[d] non nul, ok
+   ayant quad+1 cases). p[n-1] varie le plus vite et p[0]
+   est le complément. Avec p[0] < 0, donne la première.
+   Retourne 0 s'il n'y en a plus. */
+int compnext(int n, int *p, int quad, const unsigned long *ok);
+
+
+/* * Constellation et mapping
+ *
+ * Une constellation est une liste de q = 2^m points à
+ * coordonnées entières. Un mapping pi associe à chaque
+ * élément de GF(q) l'indice d'un point de la
+ * constellation.
+ */
+
+struct point { int x, y; };
+
+
+/* Lit la constellation du fichier constfile. Retourne sa
+   taille q et range son ordre m dans *m. Le tableau *C est
+   alloué et doit être libéré par l'appelant. */
+size_t const_read(const char *constfile, struct point **C, size_t *m);
+
+
+/* Lit un mapping de taille q sur f. Retourne false si f ne
+   contient plus de mapping et quitte sur un mapping
+   incomplet ou incorrect. */
+bool map_read(FILE *f, size_t q, size_t *pi);
+
+
+/* ** Tables de quadrances et de voisinages */
+
+struct mapping {
+  size_t q;          /* Taille du corps et de la constellation */
+  size_t w;          /* Voisins gardés par élément */
+  struct point *P;   /* P[i] = C[pi[i]], point de l'élément i */
+  gf_elt *V;         /* V[i*w + d] d-ème voisin le plus proche de i */
+  unsigned *Q;       /* Q[i*w + d] quadrance entre i et V[i*w + d] */
+  unsigned qmin;     /* Plus petite quadrance non nulle */
+  unsigned qmax;     /* Rayon des voisinages */
+};
+
+
+/* Construit les tables V et Q pour la constellation C et
+   le mapping pi. Seuls les w premiers voisins de chaque
+   élément sont gardés, w étant le plus petit nombre qui
+   contienne, pour tout élément, tous ses voisins à
+   quadrance inférieure à qmax : un parcours des voisins
+   borné par qmax s'arrête donc toujours avant d = w. Avec
+   qmax = UINT_MAX, w = q et les tables sont complètes. */
+void map_init(struct mapping *M, size_t q, const struct point *C, const size_t *pi,
+              unsigned qmax);
+
+/* Quadrance entre deux éléments quelconques i et j. */
+static inline unsigned map_quad(const struct mapping *M, gf_elt i, gf_elt j) {
+  unsigned dx = M->P[i].x - M->P[j].x;
+  unsigned dy = M->P[i].y - M->P[j].y;
+  return dx * dx + dy * dy;
+}
+
+/* Affiche les voisinages, par ligne i les couples
+   voisin:quadrance (mode DEBUG). */
+void map_print(const struct mapping *M);
+
+/* Libère les tables du mapping. */
+void map_free(struct mapping *M);
+
+
+/* * Statistiques de recherche
+ *
+ * Compteurs d'effort sur chaque boucle et chaque point
+ * d'élagage, affichés par st_report. Ils ne sont compilés
+ * qu'avec -DSTATS ; sinon ST_ADD et ST_HIT ne font rien.
+ */
+
+enum {
+  ST_PARITIES,               /* Parités visitées */
+  ST_CUT,                    /* Parités coupées par Sbest */
+  ST_CUT_FIRST,              /* ... dès le premier mot de code */
+  ST_CODEWORDS,              /* Mots de code (ou vecteurs) parcourus */
+  ST_NEIGHBOURS,             /* Voisins générés */
+  ST_CAPPED,                 /* Voisins évités par le cappage dcap */
+  ST_FAR,                    /* Voisins de quadrance >= qmax */
+  ST_CHECKS,                 /* Tests de syndrome */
+  ST_VALID,                  /* ... réussis */
+  ST_COUNTERS
+};
+
+/* Les voisins mots de code sont aussi comptés par
+   quadrance, la dernière case regroupant les plus grandes. */
+#define ST_LEVELS 256
+
+struct stats {
+  unsigned long long c[ST_COUNTERS];
+  unsigned long long hits[ST_LEVELS];
+};
+
+#ifdef STATS
+extern struct stats st_counts;
+#define ST_ADD(k, v) (st_counts.c[k] += (v))
+#define ST_HIT(quad, v) \
+  (st_counts.hits[(quad) < ST_LEVELS ? (quad) : ST_LEVELS - 1] += (v))
+#else
+#define ST_ADD(k, v) ((void) 0)
+#define ST_HIT(quad, v) ((void) 0)
+#endif
+
+/* Affiche les compteurs sur f, sans rien écrire sans
+   -DSTATS. La première ligne, « effort: ... », est destinée
+   aux scripts de mesure. */
+void st_report(FILE *f);
+
+
+/* * Progression
+ *
+ * Avec BESTPARITY_PROGRESS=période (en secondes), un
+ * enregistrement d'avancement est écrit sur stderr à
+ * chaque période ; SIGUSR1 en force un (période 0 : sur
+ * SIGUSR1 seulement). Sans la variable, rien n'est écrit et
+ * SIGUSR1 n'est pas intercepté. Un enregistrement est une
+ * ligne de champs clé=valeur, tous présents et dans cet
+ * ordre, « - » notant une valeur inconnue :
+ *
+ *   progress: unit=parities done=1234 total=5000 elapsed=60.0 rate=20.5 cut=0.8120 eta=184
+ *
+ * unit     unité de done et total (parities, bytes, vectors)
+ * done     unités faites
+ * total    unités à faire
+ * elapsed  secondes depuis pg_start
+ * rate     unités par seconde, lissé sur les dernières périodes
+ * cut      proportion de parités coupées, cf. pg_parity
+ * eta      secondes restantes estimées
+ */
+
+extern volatile sig_atomic_t pg_due;
+extern unsigned long long pg_parities, pg_cut; /* Parités évaluées, coupées */
+
+/* Démarre le suivi de total unités what (total = 0 si
+   inconnu). */
+void pg_start(const char *what, unsigned long long total);
+
+/* Écrit l'enregistrement d'avancement pour done unités
+   faites. */
+void pg_print(unsigned long long done);
+
+/* Arrête le minuteur. */
+void pg_stop(void);
+
+/* À appeler régulièrement : n'écrit que si une ligne est
+   due. */
+static inline void pg_tick(unsigned long long done) {
+  if (pg_due) pg_print(done);
+}
+
+/* Compte une parité évaluée, coupée ou non, pour le taux
+   de coupure (cut reste « - » sans aucun appel). */
+static inline void pg_parity(bool cut) {
+  pg_parities++;
+  pg_cut += cut;
+}
+
+
+/* * Compteurs matériels
+ *
+ * Avec BESTPARITY_PERF=1, le programme compte par phase
+ * (construction des tables, recherche, sorties) les
+ * cycles, instructions, défauts de cache L1d et LLC et
+ * mauvaises prédictions de branchement, via
+ * perf_event_open. Les événements
+ * indisponibles sont omis ; si aucun ne l'est, un message
+ * le signale et l'exécution continue sans compteurs.
+ */
+
+/* Chaque changement de phase lit le groupe par un appel
+   système : les phases ne changent qu'aux frontières
+   grossières (tables, puis recherche entrecoupée des
+   sorties), jamais par mot de code. */
+enum { PF_TABLES, PF_SEARCH, PF_OUTPUT, PF_PHASES };
+enum { PF_CYCLES, PF_INSTRUCTIONS, PF_L1D_MISSES, PF_LLC_MISSES,
+       PF_BRANCH_MISSES, PF_EVENTS };
+
+extern bool pf_enabled;
+
+/* Lit BESTPARITY_PERF. */
+void pf_start(void);
+
+/* Termine la phase courante et passe à phase. */
+void pf_switch(int phase);
+
+static inline void pf_phase(int phase) {
+  if (pf_enabled) pf_switch(phase);
+}
+
+/* Affiche le total par phase sur f. */
+void pf_report(FILE *f);
+
+
+/* * Traces
+ *
+ * Avec BESTPARITY_TRACE=fichier, chaque intervalle marqué
+ * (lecture du mapping, construction des tables, évaluation
+ * d'une parité ou d'un vecteur, sorties) est enregistré
+ * avec ses indices de parité et de mapping, puis exporté
+ * au format JSON de Chrome (chrome://tracing, Perfetto) à
+ * la fin ou sur SIGUSR2. Les 65536 derniers événements
+ * sont gardés.
+ *
+ *   uint64_t t0 = tr_begin();
+ *   ...
+ *   tr_end(TR_PARITY, t0, rang, mapping);
+ *
+ * SIGUSR2 est servi au prochain tr_record ou tr_poll ; les
+ * boucles sur les mots de code appellent tr_poll, si bien
+ * qu'une parité très longue n'empêche pas l'export.
+ * L'intervalle en cours n'y figure qu'une fois terminé.
+ */
+
+enum {
+  TR_MAPPING,                /* Lecture du mapping et tables Q, V */
+  TR_TABLES,                 /* Tables du corps */
+  TR_PARITY,                 /* Évaluation d'une parité */
+  TR_VECTOR,                 /* Un vecteur x de spectra */
+  TR_OUTPUT,                 /* Écriture des résultats */
+  TR_KINDS
+};
+
+extern bool tr_enabled;
+extern volatile sig_atomic_t tr_due;
+
+/* Lit BESTPARITY_TRACE et installe SIGUSR2 ; process nomme
+   le processus dans la trace. */
+void tr_start(const char *process);
+
+/* Horloge monotone en ns. */
+uint64_t tr_now(void);
+
+/* Enregistre l'intervalle [t0, maintenant] ; index et
+   mapping valent -1 s'ils sont sans objet. */
+void tr_record(int kind, uint64_t t0, long long index, int mapping);
+
+/* Écrit la trace complète (appelé aussi sur SIGUSR2). */
+void tr_dump(void);
+
+/* Point sûr : exporte la trace si SIGUSR2 l'a demandé. */
+static inline void tr_poll(void) {
+  if (tr_due) {
+    tr_due = 0;
+    tr_dump();
+  }
+}
+
+/* Écrit la trace et arrête l'enregistrement. */
+void tr_stop(void);
+
+static inline uint64_t tr_begin(void) {
+  return tr_enabled ? tr_now() : 0;
+}
+
+static inline void tr_end(int kind, uint64_t t0, long long index, int mapping) {
+  if (tr_enabled) tr_record(kind, t0, index, mapping);
+}
+
+
+/* * Coût par parité
+ *
+ * Avec BESTPARITY_COST=N, le temps et le nombre de voisins
+ * générés pour chaque parité alimentent deux histogrammes
+ * logarithmiques ; à la fin sont affichées les N parités les
+ * plus lentes, avec leurs coefficients, la quadrance
+ * observée et sa multiplicité.
+ *
+ *   struct co_mark c = co_begin(voisins);
+ *   ...
+ *   co_end(c, voisins, rang, h, quad, mult, coupée);
+ *
+ * où voisins est un compteur de voisins générés tenu par
+ * l'appelant (E.neighbours pour un évaluateur), relevé au
+ * début et à la fin.
+ */
+
+struct co_mark {
+  uint64_t t, work;
+};
+
+extern bool co_enabled;
+
+/* Lit BESTPARITY_COST pour des parités de longueur n. */
+void co_start(size_t n);
+
+/* Enregistre une parité évaluée depuis t0, qui a généré
+   work voisins. */
+void co_record(uint64_t t0, uint64_t work, long long rank, const gf_elt *h,
+               unsigned quad, long long mult, bool cut);
+
+/* Affiche histogrammes et palmarès sur f. */
+void co_report(FILE *f);
+
+static inline struct co_mark co_begin(uint64_t work) {
+  struct co_mark c = {0, 0};
+  if (co_enabled) {
+    c.t = tr_now();
+    c.work = work;
+  }
+  return c;
+}
+
+static inline void co_end(struct co_mark c, uint64_t work, long long rank,
+                          const gf_elt *h, unsigned quad, long long mult, bool cut) {
+  if (co_enabled) co_record(c.t, work - c.work, rank, h, quad, mult, cut);
+}
+
+
+/* * Évaluation des parités
+ *
+ * Un évaluateur regroupe tout ce qui ne dépend que du
+ * mapping, de la longueur n et de qmax : le cappage dcap
+ * des incréments et les tableaux de travail du parcours des
+ * voisins. Il est construit une seule fois puis réutilisé
+ * pour autant de parités que nécessaire.
+ */
+
+struct evaluator {
+  const struct mapping *M;
+  size_t n;                  /* Longueur du code */
+  size_t r;                  /* Nombre de parités, cf. ev_checks */
+  unsigned qmax;             /* Borne (exclue) des spectres */
+  size_t *dcap;              /* dcap[w*q + j]: incrément max au poids w */
+  unsigned long *Sinf;       /* Spectre infini, pour ne rien couper */
+  gf_elt *x, *y;             /* Mot de code x et voisin y */
+  size_t *da;                /* Incréments */
+  unsigned *df;              /* Pointeurs de focus */
+  int *ddir;                 /* Directions */
+  int *dp;                   /* Positions non nulles de da */
+  int dchg;                  /* Position changée par nb_next, -1 si toutes */
+  unsigned *qy;              /* qy[i]: quadrance de y[i] à x[i] */
+  uint64_t *hy;              /* hy[i*q + y]: syndromes de y en i, m bits par ligne */
+
+  /* Lots de voisins pour les noyaux (m <= 8) */
+  bool batch;                /* Évaluation par lots possible */
+  bool sliced;               /* Syndromes en tranches de bits (m <= 4) */
+  struct gf_mul *hm;         /* Coefficients de la matrice, ligne par ligne */
+  uint32_t *T;               /* T[x*w + d]: quadrance et symbole du d-ème voisin de x */
+  uint16_t *Eb;              /* Eb[i*KERN_BLOCK + k]: indice x[i]*w + da[i] du k-ème voisin */
+  uint8_t *Yb;               /* Yb[i*KERN_BLOCK + k]: symbole i du k-ème voisin */
+  unsigned *qb;              /* Quadrances des voisins */
+  uint8_t *sb;               /* Syndromes des voisins */
+  size_t nb;                 /* Nombre de voisins en attente */
+  unsigned long long neighbours; /* Voisins générés depuis ev_init, cf. co_begin */
+
+  unsigned long long *nfull; /* nfull[w]: incréments de poids w sans cappage */
+
+  /* Parcours des voisins par quadrance croissante */
+  bool sorted;               /* BESTPARITY_SORTED */
+  unsigned *pool;            /* Sommets, cf. ev_sorted */
+  unsigned *bucket;          /* bucket[quad]: pile des sommets à quadrance quad */
+  unsigned npool, nsfree;    /* Sommets alloués, liste des libres */
+  size_t poolsize;
+};
+
+
+/* ** Parcours des voisins
+ *
+ * Les voisins y de x s'obtiennent par des incréments da :
+ * y[i] = V[x[i]*w + da[i]]. Pour un poids dw donné, les
+ * positions non nulles dp sont parcourues en ordre
+ * lexicographique et les valeurs des incréments par un code de
+ * Gray à pointeurs de focus (df, ddir), chaque da[i] étant
+ * limité par dm[x[i]]. dp se termine par -1.
+ *
+ * Un pas du code de Gray ne change qu'une position, notée
+ * dans dchg ; un changement de dp les change toutes
+ * (dchg = -1).
+ */
+
+/* Place dans E le premier incrément de poids dw. */
+static inline void nb_begin(struct evaluator *E, size_t dw) {
+  for (size_t i = 0; i < E->n; ++i) E->da[i] = 0;
+  for (size_t j = 0; j <= dw; ++j) {
+    E->dp[j] = dw - 1 - j;
+    E->df[j] = j;
+    E->ddir[j] = +1;
+  }
+  for (int *dpj = E->dp; *dpj >= 0; ++dpj) E->da[*dpj] = 1;
+  E->dchg = -1;
+}
+
+
+/* Passe à l'incrément suivant de poids dw autour de x, avec
+   le cappage dm = E->dcap + dw*q. Retourne false après le
+   dernier. */
+static inline bool nb_next(struct evaluator *E, size_t dw,
+                           const size_t *dm, const gf_elt *x) {
+  size_t n = E->n;
+  size_t *da = E->da;
+  unsigned *df = E->df;
+  int *ddir = E->ddir;
+  int *dp = E->dp;
+
+  /* Voisin suivant (sur da) */
+  size_t j = df[0];
+  size_t pj = dp[j];
+  df[0] = 0;
+  if (j < dw) {
+    da[pj] += ddir[j];
+    if (da[pj] == 1 || da[pj] >= dm[x[pj]]) {
+      ddir[j] = -ddir[j];
+      df[j] = df[j+1];
+      df[j+1] = j+1;
+    }
+    E->dchg = pj;
+    return true;
+  }
+
+  /* Voisin suivant (sur dp) */
+  size_t i = 0;
+  while (i < dw && dp[i] >= (int) (n - i - 1)) ++i;
+  if (i == dw) return false; /* dernier sous-ensemble de poids dw */
+  for (dp[i]++; i; i--) dp[i-1] = dp[i] + 1;
+
+  for (size_t i = 0; i < n; ++i) da[i] = 0;
+  for (int *dpj = dp; *dpj >= 0; ++dpj) da[*dpj] = 1;
+  for (size_t j = 0; j <= dw; ++j) {
+    df[j] = j;
+    ddir[j] = +1;
+  }
+  E->dchg = -1;
+  return true;
+}
+
+
+/* Prépare un évaluateur pour le mapping M, construit avec
+   un rayon au moins qmax. */
+void ev_init(struct evaluator *E, const struct mapping *M, size_t n, unsigned qmax);
+
+/* Passe à des matrices de parité à r lignes (cf. pcm_size),
+   avec r m <= 64 ; par défaut, r = 1. */
+void ev_checks(struct evaluator *E, size_t r);
+
+/* Libère l'évaluateur. */
+void ev_free(struct evaluator *E);
+
+/* Calcule dans S le spectre de la parité h (de la matrice
+   h si E->r > 1). Le calcul s'arrête dès que S est moins
+   bon que Sbest, ou jamais si Sbest est NULL. Retourne
+   false si le calcul a été coupé. */
+bool ev_spectrum(struct evaluator *E, const gf_elt *h,
+                 unsigned long *S, const unsigned long *Sbest);
+
+
+/* Évaluation par lots: calcule les spectres complets des
+   count parités rangées à la suite dans H (count * n
+   coefficients) et les range dans S (count * qmax
+   multiplicités). */
+void bp_evaluate(const struct mapping *M, size_t n,
+                 const gf_elt *H, size_t count,
+                 unsigned qmax, unsigned long *S);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BESTPARITY_H */
@@ -0,0 +1,164 @@
+#include <string.h>
+
+#include "bestparity.h"
+
+
+/* * Forme canonique des parités
+ *
+ * Deux parités ont le même spectre si l'une se déduit de
+ * l'autre par
+ *
+ * - une permutation des positions ;
+ * - la multiplication de h par un scalaire non nul, qui ne
+ *   change pas le code (en logarithmes, h_i -> h_i + t) ;
+ * - et, si elles préservent les quadrances du mapping, les
+ *   applications x -> b sigma(x) de chaque symbole, où
+ *   sigma est un automorphisme de Frobenius x -> x^(2^k) et
+ *   b un scalaire. Avec b pris dans le sous-groupe engendré
+ *   par alpha^d, chaque position peut être décalée
+ *   indépendamment d'un multiple de d ; sigma, lui, agit
+ *   sur toutes les positions à la fois (h_i -> 2^k h_i).
+ *
+ * La forme canonique est la plus petite, dans l'ordre
+ * lexicographique, des formes h0 >= h1 >= ... >= 0 obtenues
+ * en ramenant chaque coefficient à zéro tour à tour, pour
+ * chaque sigma admissible, les logarithmes étant pris
+ * modulo d.
+ */
+
+
+/* Vrai si x -> alpha^t sigma_k(x) préserve les quadrances
+   de M. */
+static bool chk_preserves(const struct mapping *M, unsigned k, unsigned t) {
+  const size_t q = M->q;
+  gf_elt *img = malloc(q * sizeof *img);
+  img[0] = 0;
+  for (size_t x = 1; x < q; ++x)
+    img[x] = gf_exp[((unsigned long) gf_log[x] * (1u << k) + t) % gf_size_minus_1];
+
+  bool ok = true;
+  for (size_t x = 0; ok && x < q; ++x)
+    for (size_t y = x + 1; y < q; ++y)
+      if (map_quad(M, img[x], img[y]) != map_quad(M, x, y)) {
+        ok = false;
+        break;
+      }
+  free(img);
+  return ok;
+}
+
+
+void chk_group_init(struct chk_group *G, const struct mapping *M, bool autos) {
+  G->nfrob = 1;
+  G->frob[0] = 1;
+  G->d = gf_size_minus_1;
+  if (!autos) return;
+
+  /* Sous-groupe multiplicatif : le plus petit diviseur d de
+     q-1 tel que alpha^d préserve les quadrances */
+  for (unsigned d = 1; d < gf_size_minus_1; ++d)
+    if (gf_size_minus_1 % d == 0 && chk_preserves(M, 0, d)) {
+      G->d = d;
+      break;
+    }
+
+  /* Frobenius, à un scalaire près */
+  for (unsigned k = 1; k < gf_degree; ++k)
+    for (unsigned t = 0; t < G->d; ++t)
+      if (chk_preserves(M, k, t)) {
+        G->frob[G->nfrob++] = (1u << k) % gf_size_minus_1;
+        break;
+      }
+}
+
+
+static int chk_desc(const void *a, const void *b) {
+  gf_elt x = *(const gf_elt *) a, y = *(const gf_elt *) b;
+  return (x < y) - (x > y);
+}
+
+
+static bool chk_less(size_t n, const gf_elt *a, const gf_elt *b) {
+  for (size_t i = 0; i < n; ++i)
+    if (a[i] != b[i]) return a[i] < b[i];
+  return false;
+}
+
+
+void chk_canon(size_t n, const gf_elt *h, const struct chk_group *G, gf_elt *c) {
+  gf_elt *t = malloc(n * sizeof *t);
+  bool first = true;
+  for (unsigned f = 0; f < G->nfrob; ++f)
+    for (size_t j = 0; j < n; ++j) {
+      for (size_t i = 0; i < n; ++i) {
+        unsigned long v = gf_size_minus_1 + h[i] - h[j];
+        t[i] = v * G->frob[f] % gf_size_minus_1 % G->d;
+      }
+      qsort(t, n, sizeof *t, chk_desc);
+      if (first || chk_less(n, t, c)) {
+        memcpy(c, t, n * sizeof *t);
+        first = false;
+      }
+    }
+  free(t);
+}
+
+
+/* * Ensemble de parités
+ *
+ * Adressage ouvert avec sondage linéaire, la table doublant
+ * dès qu'elle est à moitié pleine.
+ */
+
+static uint64_t chk_hash(size_t n, const gf_elt *h) {
+  uint64_t x = 0x9e3779b97f4a7c15ull;
+  for (size_t i = 0; i < n; ++i) {
+    x ^= h[i];
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 32;
+  }
+  return x;
+}
+
+
+void chk_set_init(struct chk_set *S, size_t n) {
+  S->n = n;
+  S->len = 0;
+  S->size = 64;
+  S->keys = malloc(S->size * n * sizeof *S->keys);
+  S->slots = malloc(S->size * sizeof *S->slots);
+  for (size_t i = 0; i < S->size; ++i) S->slots[i] = SIZE_MAX;
+}
+
+
+static void chk_set_grow(struct chk_set *S) {
+  size_t size = 2 * S->size;
+  S->keys = realloc(S->keys, size * S->n * sizeof *S->keys);
+  free(S->slots);
+  S->slots = malloc(size * sizeof *S->slots);
+  for (size_t i = 0; i < size; ++i) S->slots[i] = SIZE_MAX;
+  S->size = size;
+  for (size_t k = 0; k < S->len; ++k) {
+    size_t i = chk_hash(S->n, S->keys + k * S->n) & (size - 1);
+    while (S->slots[i] != SIZE_MAX) i = (i + 1) & (size - 1);
+    S->slots[i] = k;
+  }
+}
+
+
+size_t chk_set_add(struct chk_set *S, const gf_elt *h) {
+  if (2 * (S->len + 1) > S->size) chk_set_grow(S);
+  const size_t n = S->n;
+  size_t i = chk_hash(n, h) & (S->size - 1);
+  for (; S->slots[i] != SIZE_MAX; i = (i + 1) & (S->size - 1))
+    if (memcmp(S->keys + S->slots[i] * n, h, n * sizeof *h) == 0)
+      return S->slots[i];
+  memcpy(S->keys + S->len * n, h, n * sizeof *h);
+  return S->slots[i] = S->len++;
+}
+
+
+void chk_set_free(struct chk_set *S) {
+  free(S->keys);
+  free(S->slots);
+}
@@ -0,0 +1,95 @@
+#include "bestparity.h"
+
+
+/* * Bibliothèque de combinatoire */
+
+
+/* Retourne la représentation binaire du sous ensemble qui
+   suit celle de b selon l'algorithme de banker. */
+unsigned long banker(unsigned long b, int length)
+{
+    unsigned int z = 0, y = 0;
+    unsigned long i = 1, max = 1 << length;
+    while (i < max && b & i)
+        y++, i <<= 1;
+    while (i < max && !(b & i))
+        z++, i <<= 1;
+    if (i < max) {
+        b &= ~i;
+        i = ~((1 << (z + y + 1)) - 1);
+    }
+    b &= i;
+    i = (1 << (y + z)) - (1 << (z - 1));
+    b |= i;
+    return b & (max - 1);
+}
+
+
+/* Retourne la composition suivante de quad en n parts
+   admissibles. p[1..n-1] forment un odomètre, p[n-1] en
+   poids faible, sur les valeurs de somme au plus quad ;
+   p[0] complète la somme et seuls les états où toutes les
+   parts sont admissibles sont retournés. */
+int compnext(int n, int *p, int quad, const unsigned long *ok) {
+  bool start = p[0] < 0;
+  if (start)
+    for (int i = 1; i < n; ++i) p[i] = 0;
+
+  for (;; start = false) {
+    if (!start) {
+      int i;
+      for (i = n-1; i >= 1; --i) {
+        int s = 0;
+        for (int j = 1; j < n; ++j) s += p[j];
+        if (s < quad) {
+          p[i]++;
+          break;
+        }
+        p[i] = 0;
+      }
+      if (i < 1) return 0;
+    }
+
+    int rest = quad;
+    bool valid = true;
+    for (int i = 1; i < n; ++i) {
+      rest -= p[i];
+      valid = valid && ok[p[i]];
+    }
+    if (valid && ok[rest]) {
+      p[0] = rest;
+      return 1;
+    }
+  }
+}
+
+
+/* Retourne la prochaine permutation de p selon l'algorithme
+   3.12.4 de [P. Cameron, "Combinatorics: Topics,
+   Techniques, Algorithms," Cambridge University Press,
+   1994]. */
+int permnext(int n, int *p) {
+  int j, k;
+
+  for (j = n-2; j >= 0; --j)
+    if (p[j] < p[j+1])
+      break;
+
+  if (j < 0) return 0;
+
+  for (k = n-1; k > j; --k)
+    if (p[k] > p[j])
+      break;
+
+  int tmp = p[j];
+  p[j] = p[k];
+  p[k] = tmp;
+
+  for (k = n-1, j++; j < k; j++, k--) {
+    int tmp = p[j];
+    p[j] = p[k];
+    p[k] = tmp;
+  }
+
+  return 1;
+}
@@ -0,0 +1,163 @@
+#include <string.h>
+
+#include "bestparity.h"
+
+
+/* * Coût par parité
+ *
+ * Deux histogrammes en échelle logarithmique (temps
+ * d'évaluation et voisins générés) et un tas minimum des
+ * co_top parités les plus lentes, que co_report affiche. Le
+ * travail est le nombre de voisins générés, compté par
+ * l'appelant.
+ */
+
+#define CO_BUCKETS 64
+
+struct co_entry {
+  uint64_t ns, work;
+  long long rank;
+  unsigned quad;
+  long long mult;
+  bool cut;
+  gf_elt *h;
+};
+
+struct co_state {
+  unsigned long long time[CO_BUCKETS], work[CO_BUCKETS];
+  unsigned long long count;
+  struct co_entry *top;        /* Tas minimum sur ns */
+  size_t ntop;
+};
+
+bool co_enabled;
+
+static size_t co_top;          /* Taille du palmarès */
+static size_t co_n;            /* Longueur des parités */
+static struct co_state co_total;
+
+
+void co_start(size_t n) {
+  const char *env = getenv("BESTPARITY_COST");
+  co_top = env != NULL ? strtoul(env, NULL, 10) : 0;
+  co_enabled = co_top > 0;
+  co_n = n;
+}
+
+
+static unsigned co_log2(uint64_t v) {
+  return v == 0 ? 0 : 63 - __builtin_clzll(v);
+}
+
+
+static void co_alloc(struct co_state *s) {
+  if (s->top != NULL) return;
+  s->top = malloc(co_top * sizeof *s->top);
+  gf_elt *h = malloc(co_top * co_n * sizeof *h);
+  if (s->top == NULL || h == NULL)
+    error("Mémoire insuffisante pour le coût par parité.");
+  for (size_t i = 0; i < co_top; ++i)
+    s->top[i].h = h + i * co_n;
+}
+
+
+static void co_sift(struct co_entry *t, size_t len, size_t i) {
+  for (;;) {
+    size_t l = 2 * i + 1, r = l + 1, min = i;
+    if (l < len && t[l].ns < t[min].ns) min = l;
+    if (r < len && t[r].ns < t[min].ns) min = r;
+    if (min == i) return;
+    struct co_entry tmp = t[i];
+    t[i] = t[min];
+    t[min] = tmp;
+    i = min;
+  }
+}
+
+
+/* Insère e dans le palmarès de s s'il y a sa place. */
+static void co_push(struct co_state *s, const struct co_entry *e) {
+  co_alloc(s);
+  struct co_entry *t = s->top;
+  size_t i;
+  if (s->ntop < co_top) {
+    i = s->ntop++;
+  } else if (e->ns > t[0].ns) {
+    i = 0;
+  } else {
+    return;
+  }
+
+  gf_elt *h = t[i].h;
+  memcpy(h, e->h, co_n * sizeof *h);
+  t[i] = *e;
+  t[i].h = h;
+
+  if (i == 0) {
+    co_sift(t, s->ntop, 0);
+  } else {
+    for (; i > 0 && t[(i - 1) / 2].ns > t[i].ns; i = (i - 1) / 2) {
+      struct co_entry tmp = t[i];
+      t[i] = t[(i - 1) / 2];
+      t[(i - 1) / 2] = tmp;
+    }
+  }
+}
+
+
+void co_record(uint64_t t0, uint64_t work, long long rank, const gf_elt *h,
+               unsigned quad, long long mult, bool cut) {
+  struct co_entry e = {
+    .ns = tr_now() - t0, .work = work,
+    .rank = rank, .quad = quad, .mult = mult, .cut = cut,
+    .h = (gf_elt *) h,
+  };
+  co_total.time[co_log2(e.ns)]++;
+  co_total.work[co_log2(e.work)]++;
+  co_total.count++;
+  co_push(&co_total, &e);
+}
+
+
+static void co_histogram(FILE *f, const char *what, const unsigned long long *b,
+                         unsigned long long count) {
+  size_t lo = 0, hi = CO_BUCKETS;
+  while (lo < hi && b[lo] == 0) ++lo;
+  while (hi > lo && b[hi - 1] == 0) --hi;
+
+  fprintf(f, "  %s\n", what);
+  for (size_t k = lo; k < hi; ++k) {
+    fprintf(f, "    >= 2^%-2zu %12llu  ", k, b[k]);
+    for (unsigned long long j = 0; j < 50 * b[k] / count; ++j) fputc('#', f);
+    fprintf(f, "\n");
+  }
+}
+
+
+static int co_slower(const void *a, const void *b) {
+  const struct co_entry *x = a, *y = b;
+  return (x->ns < y->ns) - (x->ns > y->ns);
+}
+
+
+void co_report(FILE *f) {
+  if (!co_enabled || co_total.count == 0) return;
+
+  fprintf(f, "Coût par parité (%llu parités)\n", co_total.count);
+  co_histogram(f, "temps (ns)", co_total.time, co_total.count);
+  co_histogram(f, "voisins générés", co_total.work, co_total.count);
+
+  struct co_entry *t = co_total.top;
+  qsort(t, co_total.ntop, sizeof *t, co_slower);
+  fprintf(f, "  les %zu plus coûteuses\n", co_total.ntop);
+  fprintf(f, "    %10s %12s %15s  %-5s %12s  h\n", "rang", "temps (s)", "voisins",
+          "quad", "mult");
+  for (size_t i = 0; i < co_total.ntop; ++i) {
+    fprintf(f, "    %10lld %12.6f %15llu  %-5u %11lld%c ", t[i].rank, t[i].ns * 1e-9,
+            (unsigned long long) t[i].work, t[i].quad, t[i].mult, t[i].cut ? '+' : ' ');
+    for (size_t j = 0; j < co_n; ++j)
+      fprintf(f, " %2u", t[i].h[j]);
+    fprintf(f, "\n");
+  }
+  fprintf(f, "    (+ : évaluation coupée, multiplicité partielle)\n");
+}
@@ -0,0 +1,156 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bestparity.h"
+
+
+/* * Vérification de crible
+ *
+ * Compare les multiplicités données par crible à celles du
+ * spectre complet calculé par bp_evaluate, sur la 16-QAM
+ * (mapping DVB) de data/, n = 4, pour les CHECK_COUNT
+ * premières parités de H4-16.txt et les quadrances de
+ * CHECK_QUADS.
+ *
+ * crible n'affiche que ses améliorations : pour chaque
+ * quadrance, les parités sont données dans l'ordre
+ * strictement décroissant de leur multiplicité attendue
+ * (une par valeur), si bien que chacune doit être affichée,
+ * avec sa multiplicité. Le crible est lancé avec et sans le
+ * noyau lanes (BESTPARITY_LANES=0).
+ *
+ * Usage : crible-check [datadir] ; retourne 0 si tout
+ * concorde.
+ */
+
+#define CHECK_N 4
+#define CHECK_COUNT 16
+static const unsigned CHECK_QUADS[] = {4, 5, 8};
+
+
+struct expect {
+  gf_elt h[CHECK_N];
+  unsigned long mult;
+};
+
+static int expect_cmp(const void *a, const void *b) {
+  const struct expect *x = a, *y = b;
+  return (x->mult < y->mult) - (x->mult > y->mult);
+}
+
+
+/* Lance crible sur les len parités de E et compare ses
+   lignes à E. Retourne le nombre d'écarts. */
+static unsigned run_crible(const char *dir, unsigned quad, const struct expect *E,
+                           size_t len, bool lanes) {
+  char hfile[] = "/tmp/crible-check-XXXXXX";
+  int fd = mkstemp(hfile);
+  if (fd < 0) error("Fichier temporaire impossible");
+  FILE *f = fdopen(fd, "w");
+  for (size_t k = 0; k < len; ++k) {
+    for (size_t i = 0; i < CHECK_N; ++i) fprintf(f, "%u ", E[k].h[i]);
+    fprintf(f, "\n");
+  }
+  fclose(f);
+
+  char cmd[1024];
+  snprintf(cmd, sizeof cmd,
+           "BESTPARITY_LANES=%d ./crible %d %u %s/16-QAM.txt %s/16-DVB.txt %s 2>/dev/null",
+           lanes, CHECK_N, quad, dir, dir, hfile);
+  FILE *p = popen(cmd, "r");
+  if (p == NULL) error("Impossible de lancer crible");
+
+  unsigned bad = 0;
+  size_t k = 0;
+  char line[256];
+  while (fgets(line, sizeof line, p)) {
+    unsigned h[CHECK_N];
+    unsigned long mult;
+    if (CHECK_N + 1 != sscanf(line, "%u %u %u %u %lu", h, h + 1, h + 2, h + 3, &mult))
+      continue;
+    bool same = k < len;
+    for (size_t i = 0; same && i < CHECK_N; ++i) same = h[i] == E[k].h[i];
+    if (!same || mult != E[k].mult) {
+      printf("quad %u, lanes %d: %s", quad, lanes, line);
+      if (k < len) printf("  attendu %lu\n", E[k].mult);
+      bad++;
+    }
+    k++;
+  }
+  pclose(p);
+  remove(hfile);
+
+  if (k != len) {
+    printf("quad %u, lanes %d: %zu lignes pour %zu parités\n", quad, lanes, k, len);
+    bad++;
+  }
+  return bad;
+}
+
+
+int main(int argc, char **argv) {
+  const char *dir = argc > 1 ? argv[1] : "../data";
+  char name[256];
+
+  struct point *C;
+  size_t m;
+  snprintf(name, sizeof name, "%s/16-QAM.txt", dir);
+  size_t q = const_read(name, &C, &m);
+
+  snprintf(name, sizeof name, "%s/16-DVB.txt", dir);
+  FILE *f = fopen(name, "r");
+  if (f == NULL) error("Impossible d'ouvrir le fichier mapping '%s'.", name);
+  size_t *pi = malloc(q * sizeof *pi);
+  if (!map_read(f, q, pi)) error("Fichier mapping incomplet\n");
+  fclose(f);
+
+  gf_init(primitives[m]);
+  unsigned qmax = 0;
+  for (size_t t = 0; t < sizeof CHECK_QUADS / sizeof *CHECK_QUADS; ++t)
+    if (CHECK_QUADS[t] >= qmax) qmax = CHECK_QUADS[t] + 1;
+  struct mapping M;
+  map_init(&M, q, C, pi, qmax);
+
+  /* Parités sous la forme de chk_read, comme les lit crible */
+  snprintf(name, sizeof name, "%s/H4-16.txt", dir);
+  if (NULL == (f = fopen(name, "r"))) error("Impossible d'ouvrir '%s'.", name);
+  gf_elt *H = malloc(CHECK_COUNT * CHECK_N * sizeof *H);
+  size_t count = 0;
+  while (count < CHECK_COUNT && chk_read(f, CHECK_N, H + count * CHECK_N))
+    count++;
+  fclose(f);
+
+  unsigned long *S = malloc(count * qmax * sizeof *S);
+  bp_evaluate(&M, CHECK_N, H, count, qmax, S);
+
+  unsigned bad = 0;
+  struct expect *E = malloc(count * sizeof *E);
+  for (size_t t = 0; t < sizeof CHECK_QUADS / sizeof *CHECK_QUADS; ++t) {
+    unsigned quad = CHECK_QUADS[t];
+    for (size_t k = 0; k < count; ++k) {
+      memcpy(E[k].h, H + k * CHECK_N, sizeof E[k].h);
+      E[k].mult = S[k * qmax + quad];
+    }
+    qsort(E, count, sizeof *E, expect_cmp);
+    size_t len = 0;
+    for (size_t k = 0; k < count; ++k)
+      if (len == 0 || E[k].mult < E[len-1].mult)
+        E[len++] = E[k];
+
+    bad += run_crible(dir, quad, E, len, true);
+    bad += run_crible(dir, quad, E, len, false);
+    printf("quad %u: %zu parités\n", quad, len);
+  }
+
+  printf("%s\n", bad == 0 ? "ok" : "ÉCHEC");
+  free(E);
+  free(S);
+  free(H);
+  map_free(&M);
+  free(C);
+  free(pi);
+  gf_free();
+  return bad == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
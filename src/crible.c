@@ -3,462 +3,854 @@
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
+#include <sys/stat.h>
 
-#define error(format, ...)                                                 \
-  do {                                                                     \
-    fflush (stdout);                                                       \
-    fprintf (stderr, "%s:%d: " format, __FILE__, __LINE__, ##__VA_ARGS__); \
-    fprintf (stderr, "\n");                                                \
-    exit (EXIT_FAILURE);                                                   \
-  } while (0)
+#include "bestparity.h"
 
 
-/* * Bibliothèque GF(2^m)
- *
- * Bibliothèque pour les corps finis GF(q) avec q=2^m. Les
- * éléments du corps sont représentés par des entiers de
- * 0 à q-1.
+/* * Programme principal
  *
- * Comme la caractéristique est 2, l'addition est le ou
- * exclusif.
+ * Il s'agit de cribler une liste de parités pour une
+ * constellation et un mapping donnés selon la multiplicité
+ * d'une quadrance quad. L'algorithme général est le
+ * suivant
  *
- * Pour la multiplication, on utilise une table de
- * logarithme sur la base d'un élément primitif. Seule cette
- * table est nécessaire pour construire le corps complet.
+ * Pour chaque parité h lue
+ *   Pour chaque composition de quad en n quadrances
+ *     Pour chaque mot de code x
+ *       Pour chaque y dont les symboles sont sur les
+ *       cercles centrés en x de rayons la composition
+ *         Si y est un mot de code, incrémenter mult
+ *   Afficher h si mult est la meilleure jusqu'ici
  *
- * Pour éviter de se trimbaler sans cesse la représentation
- * du corps, on fait appel à des variables globales. Il
- * n'est donc possible de travailler qu'avec un corps à la
- * fois.
+ * Les compositions de quad ne dépendent pas de h : elles
+ * sont construites une fois pour toutes par compositions().
  *
- * La construction d'un corps fini repose sur un polynôme
- * primitif. Voici une liste pour GF(2^m) pour les premières
- * valeurs de m.
+ * Avec une liste de quadrances q1,q2,..., le crible est une
+ * cascade : les parités de multiplicité minimale pour q1
+ * sont criblées à nouveau pour q2, et ainsi de suite.
+ * Chaque niveau affiche ses améliorations successives puis
+ * le nombre de survivants. Si un préfixe P est donné, les
+ * survivants de chaque niveau sont écrits dans P-quad.txt,
+ * au format des fichiers de parités.
  */
 
+#define CRIBLE_LEVELS 16     /* Niveaux de la cascade */
+#define CANON_STRIDE 61      /* Échantillonnage des mots de code pour le tri */
+
 
-/* Liste de polynômes primitifs pour construire GF(2^m) pour
-   m allant de 1 à 10.
-
-   |    q | P                         | P binaire     | P hexdécimal |
-   |------+---------------------------+---------------+--------------|
-   |    2 | X + 1                     | 11            |          0x3 |
-   |    4 | X^2 + X + 1               | 111           |          0x7 |
-   |    8 | X^3 + X + 1               | 1011          |          0xb |
-   |   16 | X^4 + X + 1               | 1 0011        |         0x13 |
-   |   32 | X^5 + X^2 + 1             | 10 0101       |         0x25 |
-   |   64 | X^6 + X + 1               | 100 0011      |         0x43 |
-   |  128 | X^7 + X^3 + 1             | 1000 1001     |         0x89 |
-   |  256 | X^8 + X^4 + X^3 + X^2 + 1 | 1 0001 1101   |        0x11d |
-   |  512 | X^9 + X^5 + 1             | 10 0010 0001  |        0x221 |
-   | 1024 | X^10 + X^3 + 1            | 100 0000 1001 |        0x409 |
+/* ** Compositions de quad
+ *
+ * Retourne dans *comps la liste à plat des compositions de
+ * quad en n quadrances par symbole présentes dans la table
+ * (cnt[d] > 0, où cnt[d] est le nombre de couples à
+ * quadrance d), énumérées par compnext. Elles sont triées par travail
+ * attendu croissant, c'est-à-dire par le nombre moyen de
+ * voisins parcourus par mot de code, le produit des
+ * cnt[part[i]] / q sur les n-1 premières positions. Le
+ * résultat ne dépend pas de l'ordre (la coupure sur bestmult
+ * est monotone), mais les compositions bon marché
+ * atteignent plus tôt la coupure. Retourne leur nombre.
  */
-const unsigned n_primitives = 10;
-const unsigned primitives[] = {0x1, 0x3, 0x7, 0xb, 0x13, 0x25,
-                               0x43, 0x89, 0x11d, 0x221, 0x409};
 
+struct composition {
+  double work;
+  int *part;
+};
 
-/* ** Types */
+static int comp_cmp(const void *a, const void *b) {
+  const struct composition *x = a, *y = b;
+  return (x->work > y->work) - (x->work < y->work);
+}
 
-/* Un élément de GF(q) est représenté par un entier non
-   signé entre 0 et q-1.*/
-typedef unsigned gf_elt;
+static size_t compositions(size_t n, size_t q, unsigned quad,
+                           const unsigned long *cnt, int **comps) {
+  int *part = malloc(n * sizeof *part);
+  size_t len = 0, size = 16;
+  struct composition *list = malloc(size * sizeof *list);
+
+  part[0] = -1;
+  while (compnext(n, part, quad, cnt)) {
+    double work = 1;
+    for (size_t i = 0; i < n-1; ++i)
+      work *= (double) cnt[part[i]] / q;
+
+    if (len == size)
+      list = realloc(list, (size *= 2) * sizeof *list);
+    list[len].work = work;
+    list[len].part = malloc(n * sizeof *part);
+    memcpy(list[len].part, part, n * sizeof *part);
+    len++;
+  }
 
+  qsort(list, len, sizeof *list, comp_cmp);
+  *comps = malloc((len > 0 ? len : 1) * n * sizeof **comps);
+  for (size_t k = 0; k < len; ++k) {
+    memcpy(*comps + k * n, list[k].part, n * sizeof *part);
+    free(list[k].part);
+  }
+  free(list);
+  free(part);
+  return len;
+}
 
-/* ** Constantes */
 
-/* Quelques constantes sur le corps fini. */
-unsigned gf_size;                 // Taille du corps
-unsigned gf_size_minus_1;         // Taille du corps
-const gf_elt gf_zero = 0;       // Le zéro
-const gf_elt gf_one = 1;        // Le un
-gf_elt gf_alpha;                // Un élément primitif
+/* ** Crible d'une parité
+ *
+ * Tables partagées par toutes les parités et tampons de
+ * travail. cercles[r * q + x] liste les perims[r * q + x]
+ * symboles à quadrance r de x, tous les cercles étant
+ * rangés à la suite dans un seul tableau. Le cercle
+ * d'arrivée du mot de code courant est marqué dans mark par
+ * la valeur stamp, renouvelée à chaque mot de code, pour
+ * tester en une lecture si le dernier symbole y est.
+ */
 
+struct sieve {
+  size_t n, q;
+  gf_elt **cercles;
+  unsigned *perims;
+  unsigned *mark, stamp;     /* Cercle d'arrivée */
+  unsigned long long neighbours; /* Voisins générés, cf. co_begin */
+  gf_elt *x;                 /* Mot de code */
+  unsigned *idx;             /* Index sur les couples */
+  gf_elt *s;                 /* Syndromes partiels */
+  gf_elt *hy;                /* hy[i * q + y] = h[i] y */
+  uint8_t *hyl, *sl;         /* Idem par lot, cf. sieve_lanes */
+  uint8_t *tgt, *msk;        /* Cercles d'arrivée du lot */
+};
+
+
+/* Retourne la multiplicité de la quadrance des ncomps
+   compositions comps pour la parité h, ou une valeur
+   partielle supérieure à bestmult dès qu'elle le dépasse.
+   Seul un mot de code sur stride est parcouru : avec
+   stride > 1, le résultat est un estimateur de la
+   multiplicité divisée par stride. */
+static inline unsigned sieve(struct sieve *S, const gf_elt *h,
+                      const int *comps, size_t ncomps, unsigned bestmult,
+                      unsigned stride) {
+  const size_t n = S->n, q = S->q;
+  gf_elt **cercles = S->cercles;
+  const unsigned *perims = S->perims;
+  unsigned *mark = S->mark;
+  gf_elt *x = S->x, *s = S->s, *hy = S->hy;
+  unsigned *idx = S->idx;
+
+  /* Tables de multiplication par chaque coefficient */
+  for (size_t i = 0; i < n-1; ++i)
+    for (size_t y = 0; y < q; ++y) {
+      hy[i * q + y] = 0;
+      gf_accmul(&hy[i * q + y], h[i], y);
+    }
+#ifdef DEBUG
+  printf("  h:");
+  for (size_t i = 0; i < n; ++i) printf(" %2u", h[i]);
+  printf("\n");
+#endif
 
-/* La table des logarithmes: un élément non nul $x$ de GF(q)
-   s'écrit comme une puissance $\alpha^k$ d'un élément
-   primitif $\alpha$. Cette table indicée par $x$ retourne
-   la puissance $k$ correspondante. Pour 0, elle
-   retourne -1. La table gf_exp fait l'inverse, elle
-   retourne $\alpha^k$ à partir de l'indice $k$. */
-int *gf_log;
-gf_elt *gf_exp;
+  unsigned mult = 0;          // Multiplicité
+  size_t ncw = 1;             // Mots de code
+  for (size_t i = 0; i < n-1; ++i) ncw *= q;
+    
+  /* Pour chaque composition de quad */
+  for (size_t k = 0; k < ncomps; ++k) {
+    const int *part = comps + k * n;
+#ifdef DEBUG
+    printf("  p:");
+    for (size_t i = 0; i < n; ++i) printf(" %2u", part[i]);
+    printf("\n");
+#endif
 
+    /* Pour chaque mot de code, de rang cwi dans l'ordre de
+       cw_next (x[0] le plus rapide) */
+    for (size_t i = 0; i < n; ++i) x[i] = 0;
+    for (size_t cwi = 0; cwi < ncw; cwi += stride) {
+      if (stride == 1) {
+        if (cwi > 0) cw_next(n, h, x);
+      } else {
+        gf_elt acc = gf_zero;
+        for (size_t i = 0, r = cwi; i < n-1; ++i, r /= q) {
+          x[i] = r % q;
+          gf_accmul(&acc, h[i], x[i]);
+        }
+        x[n-1] = acc;
+      }
+      ST_ADD(ST_CODEWORDS, 1);
+      tr_poll();
+
+      /* Un cercle vide ne donne aucun voisin */
+      size_t e;
+      for (e = 0; e < n-1 && perims[x[e] + q * part[e]]; ++e);
+      if (e < n-1) continue;
+
+      /* Pile des syndromes partiels : s[i] est la somme des
+         h[j] y[j] pour i <= j < n-1. Seules les positions
+         que l'odomètre a changées sont recalculées, et la
+         position 0, la plus rapide, est parcourue à part :
+         chacun de ses voisins coûte une lecture de hy et
+         un ou exclusif. */
+      const gf_elt *c0 = cercles[x[0] + q * part[0]];
+      const gf_elt *hy0 = hy;
+      unsigned p0 = perims[x[0] + q * part[0]];
+      if (++S->stamp == 0) {
+        memset(mark, 0, q * sizeof *mark);
+        S->stamp = 1;
+      }
+      const unsigned stamp = S->stamp;
+      const gf_elt *cl = cercles[x[n-1] + q * part[n-1]];
+      for (unsigned k = 0; k < perims[x[n-1] + q * part[n-1]]; ++k)
+        mark[cl[k]] = stamp;
+
+      s[n-1] = 0;
+      for (size_t i = n-1; i-- > 1;) {
+        idx[i] = 0;
+        s[i] = s[i+1] ^ hy[i * q + cercles[x[i] + q * part[i]][0]];
+      }
+      for (;;) {
+        const gf_elt base = s[1];
+        for (unsigned j = 0; j < p0; ++j) {
+          gf_elt y = base ^ hy0[c0[j]];
 
-/* ** Opérations algébriques */
+#ifdef DEBUG
+          printf("  idx: %u", j);
+          for (size_t i = 1; i < n-1; ++i) printf(" %u", idx[i]);
+          printf("\tx:");
+          for (size_t i = 0; i < n; ++i) printf(" %u", x[i]);
+          printf("\ty:");
+          for (size_t i = 0; i < n-1; ++i)
+            printf(" %u", cercles[x[i] + q * part[i]][i == 0 ? j : idx[i]]);
+          printf("\t%c\n", y == 0 ? '*' : ' ');
+#endif
 
-/* Calcul acc <- acc + \alpha^hlog * x. hlog doit être entre
-   0 et gf_size_minus_1 exclu. */
-static inline void gf_accmul(gf_elt *acc, int hlog, gf_elt x) {
-  if (x == gf_zero) return;
-  *acc ^= gf_exp[(hlog + gf_log[x]) % gf_size_minus_1]; 
+          if (mark[y] == stamp) {
+            ST_ADD(ST_VALID, 1);
+            if (++mult > bestmult) {
+              ST_ADD(ST_NEIGHBOURS, j + 1);
+              S->neighbours += j + 1;
+              ST_ADD(ST_CHECKS, j + 1);
+              ST_ADD(ST_CUT, 1);
+              return mult;
+            }
+          }
+        }
+        ST_ADD(ST_NEIGHBOURS, p0);
+        S->neighbours += p0;
+        ST_ADD(ST_CHECKS, p0);
+
+        size_t i;
+        for (i = 1; i < n-1 && ++idx[i] == perims[x[i] + q * part[i]]; ++i)
+          idx[i] = 0;
+        if (i == n-1) break;
+        for (; i >= 1; --i)
+          s[i] = s[i+1] ^ hy[i * q + cercles[x[i] + q * part[i]][idx[i]]];
+      } /* Idx */
+    }
+  }
+  return mult;
 }
 
 
-/* ** Initialisation et libération */ 
-
-/* Initialisation du corps fini GF(q) à partir d'un polynôme
-   primitif P qui est donné par sa représentation binaire.
-   Ainsi, pour GF(8), le polynôme P = X^3 + X + 1 se
-   représente par l'entier 11 en décimal c'est-à-dire 1011
-   en binaire.
-*/
-static int gf_init(unsigned P) {
-  // Lecture de la taille en lisant le degré de P
-  gf_size = 1;
-  for (unsigned p = P; p > 0; p >>= 1)
-    gf_size <<= 1;
-  gf_size >>= 1;
-  gf_size_minus_1 = gf_size - 1;
-  
-  // Construction des tables de log et de puissances
-  gf_log = malloc(gf_size * sizeof *gf_log);
-  gf_exp = malloc(gf_size * sizeof *gf_exp); // Normalement gf_size_minus_1....
-  gf_log[gf_zero] = -1; // 0 n'est pas une puissance de alpha !
-
-  gf_elt x = gf_one;
-  for (unsigned k = 0; k < gf_size_minus_1; k++) {
-    gf_log[x] = k;              // remplissage des tables
-    gf_exp[k] = x;
-    x <<= 1;                    // puissance suivante
-    if (x >= gf_size)
-      x ^= P;
-  }
-  gf_alpha = gf_exp[1];         // élément primitif
-
-  if (x != gf_one)             // Soucis, alpha pas primitif
-    error("gf_init: Corps fini incorrect: polynôme non primitif\n");
+/* ** Crible par lots
+ *
+ * Les parités d'un lot partagent les symboles x[0..n-2] des
+ * mots de code et leurs voisins y[0..n-2] : seuls le
+ * dernier symbole, donc le cercle d'arrivée, et les
+ * syndromes partiels dépendent de la parité. Ceux-ci sont
+ * rangés en structure de tableaux, un octet par parité
+ * (m <= 8), et le noyau lanes teste d'un coup les voisins
+ * de la position 0 pour tout le lot. Chaque parité garde
+ * son compteur et sort du lot dès qu'il dépasse bestmult ;
+ * le lot s'arrête quand il n'en reste plus.
+ */
 
-  return 0;
+#define LANES_FLUSH 255      /* Voisins au plus entre deux relevés des compteurs */
+
+struct lanes {
+  unsigned *mult;
+  bool live[KERN_LANES];
+  size_t nlive;
+  uint8_t cnt[KERN_LANES];   /* Compteurs depuis le dernier relevé */
+};
+
+
+/* Reporte les compteurs dans mult et retire du lot les
+   parités coupées. */
+static void lanes_flush(struct lanes *B, uint8_t *msk, size_t P, unsigned bestmult) {
+  const size_t L = KERN_LANES;
+  for (size_t l = 0; l < L; ++l) {
+    if (B->cnt[l] == 0) continue;
+    ST_ADD(ST_VALID, B->cnt[l]);
+    B->mult[l] += B->cnt[l];
+    B->cnt[l] = 0;
+    if (B->live[l] && B->mult[l] > bestmult) {
+      ST_ADD(ST_CUT, 1);
+      B->live[l] = false;
+      B->nlive--;
+      for (size_t k = 0; k < P; ++k) msk[k * L + l] = 0;
+    }
+  }
 }
 
 
-/* Libération des ressources utilisées par le corps */
-static int gf_free() {
-  free(gf_log);
-  free(gf_exp);
-  gf_log = NULL;
-  gf_exp = NULL;
-  return 0;
+static inline void lanes_xor(uint8_t *d, const uint8_t *a, const uint8_t *b) {
+  for (size_t l = 0; l < KERN_LANES; ++l) d[l] = a[l] ^ b[l];
 }
 
 
-/* * Bibliothèque de combinatoire */
-
-
-/* Retourne la partition suivante de l'entier n. p est un
-   tableau d'entier par ordre décroissant. La fonction
-   retourne le nombre d'entier de la décomposition ou 0 si
-   c'est la dernière. */
-static int partnext(int n, int *p) {
-  /* Réécriture de <www.geeksforgeeks.org/generate-unique-partitions-of-an-integer> */
-  int k;
-  int rem = 0;
-  
-  for (k = n-1; k >=0 && p[k] <= 1; --k)
-    rem += p[k];
-
-  if (k < 0) return 0;
-  p[k]--;
-  rem++;
+/* Comme sieve pour les nb <= KERN_LANES parités hs, avec
+   stride = 1 : mult[l] reçoit la multiplicité de hs[l], ou
+   une valeur partielle supérieure à bestmult. */
+static void sieve_lanes(struct sieve *S, const gf_elt *const *hs, size_t nb,
+                        const int *comps, size_t ncomps, unsigned bestmult,
+                        unsigned *mult) {
+  const size_t n = S->n, q = S->q, L = KERN_LANES;
+  gf_elt **cercles = S->cercles;
+  const unsigned *perims = S->perims;
+  gf_elt *x = S->x;
+  unsigned *idx = S->idx;
+  uint8_t *hy = S->hyl, *s = S->sl, *tgt = S->tgt, *msk = S->msk;
+  uint8_t xl[KERN_LANES];
+
+  /* hy[(i * q + y) * L + l] = h_l[i] y, nul hors du lot */
+  memset(hy, 0, (n-1) * q * L);
+  for (size_t l = 0; l < nb; ++l)
+    for (size_t i = 0; i < n-1; ++i)
+      for (size_t y = 0; y < q; ++y) {
+        gf_elt acc = gf_zero;
+        gf_accmul(&acc, hs[l][i], y);
+        hy[(i * q + y) * L + l] = acc;
+      }
 
-  for (; rem > p[k]; k++) {
-    p[k+1] = p[k];
-    rem -= p[k];
+  struct lanes B = { .mult = mult, .nlive = nb };
+  for (size_t l = 0; l < L; ++l) {
+    mult[l] = 0;
+    B.live[l] = l < nb;
+    B.cnt[l] = 0;
   }
 
-  p[++k] = rem;
-  return k+1 < n;
-} 
-
-
-/* Retourne la prochaine permutation de p selon l'algorithme
-   3.12.4 de [P. Cameron, "Combinatorics: Topics,
-   Techniques, Algorithms," Cambridge University Press,
-   1994]. */
-static int permnext(int n, int *p) {
-  int j, k;
-
-  for (j = n-2; j >= 0; --j)
-    if (p[j] < p[j+1])
-      break;
-
-  if (j < 0) return 0;
-
-  for (k = n-1; k > j; --k)
-    if (p[k] > p[j])
-      break;
-
-  int tmp = p[j];
-  p[j] = p[k];
-  p[k] = tmp;
+  for (size_t k = 0; k < ncomps; ++k) {
+    const int *part = comps + k * n;
+    const unsigned dlast = part[n-1];
+    size_t P = 0;               /* Plus grand cercle d'arrivée */
+    for (size_t y = 0; y < q; ++y)
+      if (perims[y + q * dlast] > P) P = perims[y + q * dlast];
+
+    /* Pour chaque x[0..n-2], x[0] le plus rapide */
+    for (size_t i = 0; i < n-1; ++i) x[i] = 0;
+    for (;;) {
+      ST_ADD(ST_CODEWORDS, B.nlive);
+      tr_poll();
+      size_t e;
+      for (e = 0; e < n-1 && perims[x[e] + q * part[e]]; ++e);
+      if (e == n-1) {
+        /* Dernier symbole et cercle d'arrivée de chaque parité */
+        memset(xl, 0, L);
+        for (size_t i = 0; i < n-1; ++i)
+          lanes_xor(xl, xl, hy + (i * q + x[i]) * L);
+        for (size_t l = 0; l < L; ++l) {
+          const gf_elt *cl = cercles[xl[l] + q * dlast];
+          unsigned pl = B.live[l] ? perims[xl[l] + q * dlast] : 0;
+          for (size_t j = 0; j < P; ++j) {
+            tgt[j * L + l] = j < pl ? cl[j] : 0;
+            msk[j * L + l] = j < pl ? 0xff : 0;
+          }
+        }
+
+        const gf_elt *c0 = cercles[x[0] + q * part[0]];
+        unsigned p0 = perims[x[0] + q * part[0]];
+        unsigned pending = 0;
+        memset(s + (n-1) * L, 0, L);
+        for (size_t i = n-1; i-- > 1;) {
+          idx[i] = 0;
+          lanes_xor(s + i * L, s + (i+1) * L, hy + (i * q + cercles[x[i] + q * part[i]][0]) * L);
+        }
+        for (;;) {
+          for (unsigned j = 0; j < p0; j += LANES_FLUSH) {
+            unsigned count = p0 - j < LANES_FLUSH ? p0 - j : LANES_FLUSH;
+            if (pending + count > LANES_FLUSH) {
+              lanes_flush(&B, msk, P, bestmult);
+              if (B.nlive == 0) return;
+              pending = 0;
+            }
+            kern->lanes(s + L, hy, c0 + j, count, tgt, msk, P, B.cnt);
+            pending += count;
+          }
+          ST_ADD(ST_NEIGHBOURS, (unsigned long long) p0 * B.nlive);
+          S->neighbours += (unsigned long long) p0 * B.nlive;
+          ST_ADD(ST_CHECKS, (unsigned long long) p0 * B.nlive);
+
+          size_t i;
+          for (i = 1; i < n-1 && ++idx[i] == perims[x[i] + q * part[i]]; ++i)
+            idx[i] = 0;
+          if (i == n-1) break;
+          for (; i >= 1; --i)
+            lanes_xor(s + i * L, s + (i+1) * L,
+                      hy + (i * q + cercles[x[i] + q * part[i]][idx[i]]) * L);
+        } /* Idx */
+        lanes_flush(&B, msk, P, bestmult);
+        if (B.nlive == 0) return;
+      }
 
-  for (k = n-1, j++; j < k; j++, k--) {
-    int tmp = p[j];
-    p[j] = p[k];
-    p[k] = tmp;
+      size_t i;
+      for (i = 0; i < n-1 && ++x[i] == q; ++i)
+        x[i] = 0;
+      if (i == n-1) break;
+    }
   }
-  
-  return 1;
 }
 
-/* Passe au mot de code suivant x de la parité h et retourne
-   false si plus aucun mot de code n'est obtenable. On
-   utilise le fait ici que le dernier coefficient de h est
-   1. */
-static inline bool cwnext(unsigned n, gf_elt *h, gf_elt *x) {
-  unsigned i = 0;
-  for (i = 0; i < n-1; ++i)
-    if (x[i] == gf_size_minus_1)
-      x[i] = gf_zero;
-    else
-      break;
-  if (i == n-1) return false;
-  x[i]++;
-  
-  gf_elt acc = gf_zero;
-  for (i = 0; i < n-1; ++i)
-    gf_accmul(&acc, h[i], x[i]);
-  
-  x[n-1] = acc;
-  return true;
-}
 
+/* Ordre des représentants : multiplicité partielle
+   croissante, puis rang dans le fichier. */
+struct score {
+  unsigned mult;
+  size_t rank;
+};
 
+static int score_cmp(const void *a, const void *b) {
+  const struct score *x = a, *y = b;
+  if (x->mult != y->mult) return (x->mult > y->mult) - (x->mult < y->mult);
+  return (x->rank > y->rank) - (x->rank < y->rank);
+}
 
-/* * Programme principal
+
+/* ** Survivants
  *
- * Il s'agit de trouver la meilleure parité en terme de
- * spectre de distance pour une constellation et un mapping
- * donnés. L'algorithme général est le suivant
- */
+ * Un bit par parité de la liste d'entrée. */
 
-static int readparity(FILE *f, int n, gf_elt *h) {
-  for (unsigned i = 0; i < n; ++i)
-    if (1 != fscanf(f, "%u", h + i))
-      return 0;
-
-  /* Remet la parité h sans perte de généralité sous la
-     forme h0 h1 ... 0 avec h0 >= h1 >=... >= 0 */
-  for (unsigned i = 0; i < n; ++i)
-    for (unsigned j = i+1; j < n; ++j)
-      if (h[i] < h[j]) {
-        gf_elt tmp = h[i];
-        h[i] = h[j];
-        h[j] = tmp;
-      }
+static inline bool alive_get(const uint64_t *a, size_t i) {
+  return a[i / 64] >> (i % 64) & 1;
+}
 
-  for (unsigned i = 0; i < n; ++i)
-    h[i] -= h[n-1];
-  
-  return 1;
+static inline void alive_set(uint64_t *a, size_t i) {
+  a[i / 64] |= 1ull << (i % 64);
 }
 
 
 int main(int argc, char **argv) {
-  unsigned m;            /* GF(2^m) */
-  unsigned q;            /* Taille constellation == gf_size */
-  unsigned n;            /* Longueur du code */
-  unsigned quad;       /* Quadrance à repérer */ 
+  size_t m;            /* GF(2^m) */
+  size_t q;            /* Taille constellation == gf_size */
+  size_t n;            /* Longueur du code */
+  unsigned quads[CRIBLE_LEVELS]; /* Quadrances à repérer, par niveau */
+  size_t nquads = 0;
+  unsigned quadmax = 0;
 
   char constfile[81] = ""; /* Nom du fichier de constellation */
   char mapsfile[81] = "";  /* Nom du ficher de mappings */
   char hfile[81] = "";  /* Nom du ficher de parités ou - pour stdin */
+  const char *survfile = NULL; /* Préfixe des fichiers de survivants */
   FILE *f = NULL;
 
   /* Lecture des arguments ou de l'entrée standard */
-  if (argc == 6) {       /* Mode ligne de commande */
-    if (1 != sscanf(argv[1], "%u", &n)) error("L'option codelength doit être entier: '%s'", argv[1]);
-    if (1 != sscanf(argv[2], "%u", &quad)) error("L'option quad doit être entier: '%s'", argv[3]);
+  if (argc == 6 || argc == 7) {       /* Mode ligne de commande */
+    if (1 != sscanf(argv[1], "%zu", &n)) error("L'option codelength doit être entier: '%s'", argv[1]);
+    for (char *p = argv[2], *end; ; p = end + 1) {
+      if (nquads == CRIBLE_LEVELS) error("Au plus %d quadrances: '%s'", CRIBLE_LEVELS, argv[2]);
+      unsigned long d = strtoul(p, &end, 10);
+      if (end == p || d == 0 || d > UINT_MAX)
+        error("L'option quad doit être une liste d'entiers séparés par des virgules: '%s'", argv[2]);
+      quads[nquads++] = d;
+      if (d > quadmax) quadmax = d;
+      if (*end != ',') {
+        if (*end != '\0') error("L'option quad doit être une liste d'entiers séparés par des virgules: '%s'", argv[2]);
+        break;
+      }
+    }
     strncpy(constfile, argv[3], 80);
     strncpy(mapsfile, argv[4], 80);
     strncpy(hfile, argv[5], 80);
+    if (argc == 7) survfile = argv[6];
   } else {                      /* Mode aide */
-    printf("Usage: %s codelength quad constellation mappings parities\n", argv[0]);
+    printf("Usage: %s codelength quad[,quad...] constellation mappings parities [survivors]\n", argv[0]);
     return -1;
   }
 
   
   /* ** Lecture de la constellation sur constfile */
-  if (NULL == (f = fopen(constfile, "r")))
-    error("Impossible d'ouvrir le fichier constellation '%s'.", constfile);
-  q = 0;
-  m = 0;
-  struct { int I, Q; } *C = malloc((1 << m) * sizeof *C);
-  while (2 == fscanf(f, "%u%u", &C[q].I, &C[q].Q))
-    if (++q == (1 << m))
-      if (NULL == (C = realloc(C, (1 << ++m) * sizeof *C)))
-        error("Allocation mémoire impossible.");
-  m--;
-  fclose(f);    
+  struct point *C;
+  q = const_read(constfile, &C, &m);
 
   printf("Constellation: %s\n", constfile);
 
 
   /* ** Lecture du mapping */
-  unsigned *pi = malloc(q * sizeof *pi); // Le mapping
+  size_t *pi = malloc(q * sizeof *pi); // Le mapping
+  tr_start(argv[0]);
+  co_start(n);
+  uint64_t t0 = tr_begin();
   
   if (strcmp (mapsfile, "-") == 0)
     f = stdin;
   else if (NULL == (f = fopen(mapsfile, "r")))
     error("Impossible d'ouvrir le fichier mapping '%s'.", mapsfile); 
 
-  for (unsigned i = 0; i < q; ++i)
-    if (1 != fscanf(f, "%u", pi + i))
-      error("Fichier mapping incomplet\n");
-    else if (pi[i] >= q)
-      error("Valeur de mapping hors bornes\n");
+  if (!map_read(f, q, pi))
+    error("Fichier mapping incomplet\n");
 
   printf("Mapping:");
-  for (unsigned i = 0; i < q; ++i)
-    printf(" %u", pi[i]);
+  for (size_t i = 0; i < q; ++i)
+    printf(" %zu", pi[i]);
   printf("\n");
   if (f != stdin)
     fclose(f);
+  tr_end(TR_MAPPING, t0, -1, 0);
 
   
   /* ** Construction du corps q=2^m */
-  if (1 << m != q) error("Corps de caractéristique 2 uniquement.");
   if (n >= q) error("codelength doit être inférieur à l'ordre du corps."); 
 
+  pf_start();
+  pf_phase(PF_TABLES);
+  t0 = tr_begin();
   gf_init(primitives[m]);
-  printf("GF(%u = 2^%u)\n", q, m);  
-  printf("codelength: %u\n", n);
-  printf("quad: %u\n", quad); 
-
-
-  /* ** Quadrances entre éléments */
-  unsigned *quadrances = malloc(q * q * sizeof quadrances);
-  for (gf_elt x = 0; x < q; ++x)
-    for (gf_elt y = 0; y < q; y++) {
-      unsigned dx = C[pi[x]].I - C[pi[y]].I;
-      unsigned dy = C[pi[x]].Q - C[pi[y]].Q;
-      quadrances[x * q + y] = dx * dx + dy * dy;
+  printf("GF(%zu = 2^%zu) [%s]\n", q, m, kern->name);  
+  printf("codelength: %zu\n", n);
+  printf("quad: %u\n", quads[0]); 
+
+
+  /* ** Quadrances entre éléments, seuls les voisins à
+     quadrance au plus quadmax étant gardés */
+  struct mapping M;
+  map_init(&M, q, C, pi, quadmax + 1);
+
+
+  /* ** Répartition des couples (x, y) selon leur distance,
+     jusqu'à la plus grande quadrance demandée : on compte
+     d'abord les cercles, puis on les remplit à la suite
+     dans pool */
+  gf_elt **cercles = malloc(q * (1 + quadmax) * sizeof *cercles);
+  unsigned *perims = calloc(q * (1 + quadmax), sizeof *perims);
+  unsigned long *cnt = calloc(1 + quadmax, sizeof *cnt); // Couples par quadrance
+  for (size_t x = 0; x < q; ++x)
+    for (size_t d = 0; d < M.w; ++d) {
+      unsigned r = M.Q[x * M.w + d];
+      if (r > quadmax) break;
+      perims[r * q + x]++;
+      cnt[r]++;
     }
-  
 
-  /* ** Répartition des couples (x, y) selon leur distance */
-  gf_elt **cercles = calloc(q * (1 + quad), sizeof *cercles);
-  unsigned *perims = calloc(q * (1 + quad), sizeof *perims);
-  for (unsigned i = 0; i < q * (1 + quad); ++i)
-    cercles[i] = malloc(8 * sizeof *cercles);
-  
-  for (gf_elt x = 0; x < q; ++x)
-    for (gf_elt y = 0; y < q; y++) {
-      unsigned r = quadrances[x * q + y];
-      if (r > quad) continue;
-      
-      unsigned i = r * q + x;
-      cercles[i][perims[i]++] = y;
-      
-      unsigned k = perims[i];
-      if (k >= 8 && (k & (k-1)) == 0)
-        cercles[i] = realloc(cercles[i], 2 * k * sizeof *cercles);
+  size_t ncouples = 0;
+  for (unsigned r = 0; r <= quadmax; ++r)
+    ncouples += cnt[r];
+  gf_elt *pool = malloc((ncouples > 0 ? ncouples : 1) * sizeof *pool);
+  for (size_t i = 0, o = 0; i < q * (1 + quadmax); o += perims[i++])
+    cercles[i] = pool + o;
+
+  /* V est trié : les cercles se remplissent en ordre
+     croissant de y à quadrance égale */
+  memset(perims, 0, q * (1 + quadmax) * sizeof *perims);
+  for (size_t x = 0; x < q; ++x)
+    for (size_t d = 0; d < M.w; ++d) {
+      unsigned r = M.Q[x * M.w + d];
+      if (r > quadmax) break;
+      size_t i = r * q + x;
+      cercles[i][perims[i]++] = M.V[x * M.w + d];
     }
 
 #if DEBUG
   printf("Cercles");
-  for (gf_elt x = 0; x < q; ++x) {
-    printf("  x: %u\n", x);
-    for (unsigned r = 0; r <= quad; ++r)
+  for (size_t x = 0; x < q; ++x) {
+    printf("  x: %zu\n", x);
+    for (unsigned r = 0; r <= quadmax; ++r)
       if (perims[x + r * q] > 0) {
         printf("    %u:", r);
-        for (unsigned i = 0; i < perims[x + r * q]; ++i)
+        for (size_t i = 0; i < perims[x + r * q]; ++i)
           printf(" %u", cercles[x + r * q][i]);
         printf("\n");
       }
     }
 #endif
+  tr_end(TR_TABLES, t0, -1, 0);
   
   
   /* ** Allocation de la mémoire */
-  gf_elt *x = malloc(n * sizeof *x); // Mot de code
-  gf_elt *h = malloc(n * sizeof *h); // Parité
-  int *part = malloc(n * sizeof *part); // Partition entière de quad
-  unsigned *idx = malloc(n * sizeof *idx); // Index sur les couples 
-  unsigned bestmult = UINT_MAX; // Meilleure multiplicité
-  
+  struct sieve S = {
+    .n = n, .q = q,
+    .cercles = cercles, .perims = perims,
+    .mark = calloc(q, sizeof *S.mark),
+    .x = malloc(n * sizeof *S.x),
+    .idx = malloc(n * sizeof *S.idx),
+    .s = malloc(n * sizeof *S.s),
+    .hy = malloc((n-1) * q * sizeof *S.hy),
+  };
+  gf_elt *h = malloc(n * sizeof *h); // Parité lue
+
+  /* Crible par lots de KERN_LANES parités, si les symboles
+     tiennent sur un octet. Les traces et le coût par parité
+     demandent une mesure par parité : une à une dans ce
+     cas. */
+  const char *lenv = getenv("BESTPARITY_LANES");
+  size_t batch = m <= 8 && (lenv == NULL || atoi(lenv) != 0)
+    && !tr_enabled && !co_enabled ? KERN_LANES : 1;
+  gf_elt *hb = malloc(batch * n * sizeof *hb);   // Lot lu
+  const gf_elt *hps[KERN_LANES];                 // Parités du lot
+  size_t ranks[KERN_LANES];
+  unsigned mults[KERN_LANES];
+  if (batch > 1) {
+    S.hyl = malloc((n-1) * q * KERN_LANES);
+    S.sl = malloc(n * KERN_LANES);
+    S.tgt = malloc(q * KERN_LANES);
+    S.msk = malloc(q * KERN_LANES);
+  }
+
+  /* Prétraitement de la liste, cf. plus bas */
+  const char *env = getenv("BESTPARITY_CANON");
+  int canon = env != NULL ? atoi(env) : 0;
+
+  /* Les parités ne sont gardées en mémoire que s'il faut les
+     relire : cascade, fichiers de survivants ou
+     prétraitement. */
+  bool keep = nquads > 1 || survfile != NULL || canon > 0;
+  gf_elt *H = NULL;              // Parités lues, si keep
+  size_t nh = 0, hsize = 0;
+  uint64_t *alive = NULL;        // Parités encore à cribler
+  size_t nalive = 0;
+  size_t *order = NULL;          // Ordre de passage, NULL pour celui du fichier
+  size_t norder = 0;
+  size_t *csize = NULL;          // Taille de la classe de chaque représentant
+  unsigned long long saved = 0;  // Évaluations évitées
+
+  /* Parités retenues au fil d'un niveau (multiplicité au plus
+     la meilleure du moment) */
+  struct { size_t rank; unsigned mult; } *best = NULL;
+  size_t nbest = 0, bestsize = 0;
   
-  /* Pour chaque parité h de longueur n */
   if (strcmp (hfile, "-") == 0)
     f = stdin;
   else if (NULL == (f = fopen(hfile, "r")))
     error("Impossible d'ouvrir le fichier de parités '%s'.", hfile); 
 
-  while (readparity(f, n, h)) {
-#ifdef DEBUG
-    printf("  h:");
-    for (unsigned i = 0; i < n; ++i) printf(" %2u", h[i]);
-    printf("\n");
-#endif
-
-    unsigned mult = 0;          // Multiplicité
-    
-    /* Initialisation de la partition */
-    for (unsigned i = 2; i < n; ++i) part[i] = 0;
-    part[0] = quad - 1;
-    part[1] = 1;
-
-    do {
-      /* Pour chaque permutation de cette partition */
-      for (int i = 0, j = n-1; i < j; ++i, --j) {
-        int tmp = part[i];
-        part[i] = part[j];
-        part[j] = tmp;
-      }
-      
-      do {
-#ifdef DEBUG
-        printf("  p:");
-        for (unsigned i = 0; i < n; ++i) printf(" %2u", part[i]);
-        printf("\n");
-#endif
+  pf_phase(PF_SEARCH);
+
+
+  /* ** Prétraitement
+   *
+   * Avec BESTPARITY_CANON=1, toute la liste est lue d'abord.
+   * Chaque parité est mise sous forme canonique (cf.
+   * chk_canon) ; seule la première de chaque classe est
+   * criblée. BESTPARITY_CANON=2 réduit aussi par les
+   * automorphismes du mapping. Les représentants sont
+   * ensuite classés par leur multiplicité estimée sur un mot
+   * de code sur CANON_STRIDE, pour un coût du même ordre : les
+   * meilleures parités passent d'abord et bestmult baisse
+   * plus vite. (Sur H4-64, l'estimation suit la
+   * multiplicité à quelques pour cent près, alors que celle
+   * des seules compositions bon marché n'y est pas corrélée.)
+   */
+  if (canon > 0) {
+    t0 = tr_begin();
+    while (chk_read(f, n, h)) {
+      if (nh == hsize)
+        H = realloc(H, (hsize = hsize ? 2 * hsize : 1024) * n * sizeof *H);
+      memcpy(H + nh++ * n, h, n * sizeof *h);
+    }
 
-        /* Pour chaque mot de code */
-        for (unsigned i = 0; i < n; ++i) x[i] = 0;
-        do {
-          for (unsigned i = 0; i < n-1; ++i) idx[i] = 0;
-          for (;;) {
-            gf_elt y = 0;
-            
-            for (unsigned i = 0; i < n-1; ++i)
-              gf_accmul(&y, h[i], cercles[x[i] + q * part[i]][idx[i]]);
+    struct chk_group G;
+    chk_group_init(&G, &M, canon >= 2);
+    struct chk_set set;
+    chk_set_init(&set, n);
+    order = malloc((nh + 1) * sizeof *order);
+    csize = calloc(nh + 1, sizeof *csize);
+    for (size_t k = 0; k < nh; ++k) {
+      chk_canon(n, H + k * n, &G, h);
+      size_t cls = chk_set_add(&set, h);
+      if (cls == norder) order[norder++] = k;
+      csize[order[cls]]++;
+    }
+    chk_set_free(&set);
+
+    int *comps;
+    size_t ncomps = compositions(n, q, quads[0], cnt, &comps);
+    struct score *score = malloc((norder + 1) * sizeof *score);
+    for (size_t k = 0; k < norder; ++k) {
+      score[k].mult = sieve(&S, H + order[k] * n, comps, ncomps, UINT_MAX, CANON_STRIDE);
+      score[k].rank = order[k];
+    }
+    qsort(score, norder, sizeof *score, score_cmp);
+    for (size_t k = 0; k < norder; ++k)
+      order[k] = score[k].rank;
+    free(score);
+    free(comps);
+
+    alive = calloc((nh + 63) / 64 + 1, sizeof *alive);
+    for (size_t k = 0; k < norder; ++k)
+      alive_set(alive, order[k]);
+    nalive = norder;
+    printf("parités: %zu lues, %zu classes", nh, norder);
+    if (G.d < gf_size_minus_1 || G.nfrob > 1)
+      printf(" (automorphismes: %u Frobenius, décalages modulo %u)", G.nfrob, G.d);
+    printf("\n");
+    tr_end(TR_TABLES, t0, -1, 0);
+  }
 
-#ifdef DEBUG
-            printf("  idx:");
-            for (unsigned i = 0; i < n; ++i) printf(" %u", idx[i]);
-            printf("\tx:");
-            for (unsigned i = 0; i < n; ++i) printf(" %u", x[i]);
-            printf("\ty:");
-            for (unsigned i = 0; i < n; ++i) printf(" %u", cercles[x[i] + q * part[i]][idx[i]]);
-            printf("\t%c\n", y == 0 ? '*' : ' ');
-#endif
 
-            if (quadrances[x[n-1] * q + y] == part[n-1])
-              if (++mult > bestmult)
-                goto nexth;
-
-            unsigned i;
-            for (i = 0; i < n-1 && ++idx[i] == perims[x[i] + q * part[i]]; ++i)
-                idx[i] = 0;
-            if (i == n-1) break;
-          } /* Idx */
-        } while (cwnext(n, h, x));
-      } while (permnext(n, part));
-    } while (partnext(n, part));
-    
-  nexth:
-    if (mult <= bestmult) {
-      bestmult = mult;
-      for (unsigned i = 0; i < n; ++i) printf("%2u ", h[i]);
-      printf("\t%d\n", bestmult);
-      fflush(stdout);
+  /* ** Cascade
+   *
+   * Le premier niveau lit les parités au fil de l'eau (ou
+   * parcourt la liste prétraitée) ; chaque niveau suivant
+   * recrible, à sa quadrance, les parités de multiplicité
+   * minimale au niveau précédent.
+   */
+  for (size_t l = 0; l < nquads; ++l) {
+    unsigned quad = quads[l];
+    t0 = tr_begin();
+    int *comps;
+    size_t ncomps = compositions(n, q, quad, cnt, &comps);
+    tr_end(TR_TABLES, t0, -1, 0);
+    if (l > 0) printf("quad: %u\n", quad);
+
+    unsigned bestmult = UINT_MAX; // Meilleure multiplicité
+    nbest = 0;
+
+    /* Progression sur la position dans le fichier de
+       parités, sa taille n'étant connue que pour un fichier
+       régulier, puis sur les survivants */
+    bool stream = l == 0 && canon == 0;
+    struct stat hst;
+    if (stream)
+      pg_start("bytes", fstat(fileno(f), &hst) == 0 && S_ISREG(hst.st_mode) ? hst.st_size : 0);
+    else
+      pg_start("parities", nalive);
+
+    unsigned long long done = 0;
+    if (l == 1 && order == NULL) norder = nh;
+    for (size_t k = 0; ; ) {
+      /* Lot suivant. Ses parités sont toutes coupées sur le
+         bestmult du début du lot : celles qu'il coupe à tort
+         dépassent de toute façon le bestmult plus bas que le
+         lot lui-même peut donner, et la sortie est celle
+         d'un crible une à une. */
+      size_t nb = 0;
+      for (; nb < batch; ++nb, ++k) {
+        if (stream) {
+          gf_elt *hn = hb + nb * n;
+          if (!chk_read(f, n, hn)) break;
+          if (pg_due) {         /* ftell coûte un appel système */
+            long pos = ftell(f);
+            pg_print(pos < 0 ? 0 : pos);
+          }
+          if (keep) {
+            if (nh == hsize)
+              H = realloc(H, (hsize = hsize ? 2 * hsize : 1024) * n * sizeof *H);
+            memcpy(H + nh++ * n, hn, n * sizeof *hn);
+          }
+          hps[nb] = hn;
+          ranks[nb] = k;
+        } else {
+          while (k < norder && !alive_get(alive, order != NULL ? order[k] : k)) ++k;
+          if (k == norder) break;
+          size_t hrank = order != NULL ? order[k] : k;
+          pg_tick(done++);
+          hps[nb] = H + hrank * n;
+          ranks[nb] = hrank;
+          if (csize != NULL) saved += csize[hrank] - 1;
+        }
+      }
+      if (nb == 0) break;
+
+      t0 = tr_begin();
+      struct co_mark c = co_begin(S.neighbours);
+      ST_ADD(ST_PARITIES, nb);
+      if (batch > 1)
+        sieve_lanes(&S, hps, nb, comps, ncomps, bestmult, mults);
+      else
+        mults[0] = sieve(&S, hps[0], comps, ncomps, bestmult, 1);
+
+      for (size_t b = 0; b < nb; ++b) {
+        const gf_elt *hp = hps[b];
+        size_t hrank = ranks[b];
+        unsigned mult = mults[b];
+        tr_end(TR_PARITY, t0, hrank, 0);
+        co_end(c, S.neighbours, hrank, hp, quad, mult, mult > bestmult);
+        pg_parity(mult > bestmult);
+        ST_HIT(quad, mult);
+
+        if (mult <= bestmult) {
+          pf_phase(PF_OUTPUT);
+          uint64_t t1 = tr_begin();
+          bestmult = mult;
+          for (size_t i = 0; i < n; ++i) printf("%2u ", hp[i]);
+          printf("\t%d\n", bestmult);
+          fflush(stdout);
+          tr_end(TR_OUTPUT, t1, hrank, 0);
+
+          if (keep) {
+            if (nbest == bestsize)
+              best = realloc(best, (bestsize = bestsize ? 2 * bestsize : 64) * sizeof *best);
+            best[nbest].rank = hrank;
+            best[nbest++].mult = mult;
+          }
+        }
+      }
+      pf_phase(PF_SEARCH);
+    }
+    pg_stop();
+    free(comps);
+    if (!keep) break;
+
+    /* Survivants : les parités retenues de multiplicité
+       finale bestmult */
+    if (alive == NULL)
+      alive = malloc(((nh + 63) / 64 + 1) * sizeof *alive);
+    memset(alive, 0, ((nh + 63) / 64 + 1) * sizeof *alive);
+    nalive = 0;
+    for (size_t k = 0; k < nbest; ++k)
+      if (best[k].mult == bestmult) {
+        alive_set(alive, best[k].rank);
+        nalive++;
+      }
+    if (nquads > 1)
+      printf("survivants: %zu/%zu\n", nalive, nh);
+
+    if (survfile != NULL) {
+      pf_phase(PF_OUTPUT);
+      char name[256];
+      snprintf(name, sizeof name, "%s-%u.txt", survfile, quad);
+      FILE *g = fopen(name, "w");
+      if (g == NULL) error("Impossible d'écrire le fichier de survivants '%s'.", name);
+      for (size_t k = 0; k < nh; ++k)
+        if (alive_get(alive, k)) {
+          for (size_t i = 0; i < n; ++i)
+            fprintf(g, i + 1 < n ? "%u " : "%u\n", H[k * n + i]);
+        }
+      fclose(g);
+      pf_phase(PF_SEARCH);
     }
   }
 
+
+  if (canon > 0)
+    printf("évaluations évitées: %llu\n", saved);
+
   /* Libération des ressources */
-  free(idx);
-  free(part);
+  if (f != stdin) fclose(f);
+  free(pool);
+  free(cercles);
+  free(perims);
+  free(cnt);
+  free(H);
+  free(alive);
+  free(order);
+  free(csize);
+  free(best);
+  map_free(&M);
+  free(C);
+  free(pi);
+  free(S.mark);
+  free(S.x);
+  free(S.idx);
+  free(S.s);
+  free(S.hy);
+  free(S.hyl);
+  free(S.sl);
+  free(S.tgt);
+  free(S.msk);
   free(h);
+  free(hb);
   gf_free();
+  st_report(stderr);
+  pf_report(stderr);
+  co_report(stderr);
+  tr_stop();
 }
@@ -1,20 +1,23 @@
 #! /usr/bin/env clj
 
-;;; Génère le mapping du DVB-T2 en 16 QAM
+;;; Génère le mapping du DVB-T2 en 16 QAM, et plus
+;;; généralement d'une M-QAM carrée (1024 et 4096 compris)
 
-(def mappings
-  {4   [[1] [0]]
-   16  [[1 0] [1 1] [0 1] [0 0]]
-   64  [[1 0 0] [1 0 1] [1 1 1] [1 1 0]
-        [0 1 0] [0 1 1] [0 0 1] [0 0 0]]
-   256 [[1 0 0 0] [1 0 0 1] [1 0 1 1] [1 0 1 0]
-        [1 1 1 0] [1 1 1 1] [1 1 0 1] [1 1 0 0]
-        [0 1 0 0] [0 1 0 1] [0 1 1 1] [0 1 1 0]
-        [0 0 1 0] [0 0 1 1] [0 0 0 1] [0 0 0 0]]})
+;;; Bits des niveaux d'un axe, poids fort en tête : le niveau
+;;; a porte le code de Gray de N-1-a. Pour la 16-QAM, on
+;;; retrouve [[1 0] [1 1] [0 1] [0 0]].
+(defn levels [order]
+  (let [N (int (Math/sqrt order))
+        b (Integer/numberOfTrailingZeros N)]
+    (vec (for [a (range N)
+               :let [v (- N 1 a)
+                     g (bit-xor v (bit-shift-right v 1))]]
+           (vec (for [k (range (dec b) -1 -1)]
+                  (bit-and (bit-shift-right g k) 1)))))))
 
 
 (let [order (Integer/parseUnsignedInt (first *command-line-args*))
-      mapping (mappings order)
+      mapping (levels order)
       bits2int (fn [bs] (reduce + (map * (iterate #(* 2 %) 1) bs)))]
 
   (->> (for [q mapping i mapping] (interleave i q))
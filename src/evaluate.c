@@ -0,0 +1,525 @@
+#include <string.h>
+#include <limits.h>
+
+#include "bestparity.h"
+
+
+/* * Évaluation des parités
+ *
+ * Il s'agit de calculer le spectre de distance d'une parité
+ * pour une constellation et un mapping donnés.
+ * L'algorithme général est le suivant
+ *
+ * Initialiser un spectre de distance S
+ * Pour chaque mot de code x
+ *   Pour chaque vecteur y voisin de x
+ *     Si y est un mot de code alors
+ *       Ajouter distance(x, y) dans spectre S
+ *
+ * Pour rendre les choses plus rapide, l'élagage de la
+ * recherche se fait avec la notion de y voisin de x, cf.
+ * [ABCND1x]. Il suffit de se limiter à une distance seuil
+ * au dessus de laquelle il n'est pas nécessaire de
+ * connaître le spectre.
+ *
+ * Pour m <= 8, les voisins ne sont pas testés un par un :
+ * le parcours se contente de noter leurs incréments dans un
+ * lot de KERN_BLOCK voisins, et les noyaux calculent d'un
+ * coup leurs symboles, quadrances et syndromes. Le test de
+ * coupure voit donc le spectre avec un lot de retard, ce
+ * qui ne change rien au résultat : un spectre moins bon que
+ * Sbest le reste quand ses multiplicités augmentent.
+ *
+ * Pour m <= 4, les syndromes du lot sont calculés en
+ * tranches de bits (cf. kern->sliced) : un mot de 64 bits
+ * par bit de symbole et par position, la multiplication
+ * par h[i] devenant un réseau fixe de ou exclusifs. Le
+ * résultat est directement le masque des voisins mots de
+ * code, et seuls ceux-ci sont parcourus ensuite.
+ *
+ * Avec r > 1 parités (cf. ev_checks), les mots de code
+ * sont ceux de la matrice H et un voisin doit vérifier ses
+ * r lignes. Hors lots, ses r syndromes sont rangés côte à
+ * côte dans un entier de 64 bits, m bits par ligne, si
+ * bien que le test reste une comparaison à zéro ; par
+ * lots, chaque ligne passe par les noyaux et les syndromes
+ * sont combinés. Pour r = 1, rien ne change.
+ *
+ * Avec BESTPARITY_SORTED=1, les voisins de chaque x sont
+ * produits par quadrance croissante (cf. ev_sorted) et le
+ * spectre est comparé à Sbest à chaque changement de
+ * quadrance : une parité perdante est coupée au premier
+ * niveau où elle perd, au milieu du parcours de x.
+ */
+
+
+void ev_init(struct evaluator *E, const struct mapping *M, size_t n, unsigned qmax) {
+  size_t q = M->q, nw = M->w;
+  const unsigned *Q = M->Q;
+  const gf_elt *V = M->V;
+
+  if (qmax > M->qmax)
+    error("qmax (%u) dépasse le rayon des voisinages (%u).", qmax, M->qmax);
+  /* S[0] compte les q^(n-r) mots de code, au plus q^(n-1) */
+  if (n < 2 || gf_degree * (n - 1) >= CHAR_BIT * sizeof(unsigned long))
+    error("n = %zu non pris en charge dans GF(2^%zu) : les q^(n-1) mots de code "
+          "ne tiennent pas sur %zu bits.", n, gf_degree, CHAR_BIT * sizeof(unsigned long));
+
+  E->M = M;
+  E->n = n;
+  E->r = 1;
+  E->qmax = qmax;
+
+  /* Recherche du cappage sur delta */
+  size_t *dcap = E->dcap = malloc((n+1) * q * sizeof *dcap);
+  for (size_t w = 0; w <= n; ++w) {
+    for (size_t j = 0; j < q; ++j) {
+      size_t d = 0;
+      for (d = 0; d < nw; ++d)
+        if (Q[j * nw + d] > qmax - (w == 0 ? qmax : (w-1) * M->qmin))
+          break;
+      dcap[w * q + j] = d-1;
+    }
+  }
+
+#ifdef DEBUG
+  printf("dcap\n");
+  for (size_t w = 0; w <= n; ++w) {
+    printf("  %zu:\t", w);
+    for (size_t i = 0; i < q; ++i) printf(" %zu", dcap[w * q + i]);
+    printf("\n");
+  }
+#endif
+
+  /* Spectre qui ne coupe jamais */
+  E->Sinf = malloc(qmax * sizeof *E->Sinf);
+  for (size_t i = 0; i < qmax; ++i)
+    E->Sinf[i] = ULONG_MAX;
+
+  E->x = malloc(n * sizeof *E->x);
+  E->y = malloc(n * sizeof *E->y);
+  E->qy = malloc(n * sizeof *E->qy);
+  E->hy = malloc(n * q * sizeof *E->hy);
+
+  /* Pour les incréments on visite les sous-ensembles par ordre de poids*/
+  E->da = malloc(n * sizeof *E->da);
+  E->df = malloc((n+1) * sizeof *E->df);
+  E->ddir = malloc((n+1) * sizeof *E->ddir);
+  E->dp = malloc((n+1) * sizeof *E->dp);
+
+  /* Lots de voisins. En mode DEBUG on trace chaque voisin,
+     donc pas de lots. */
+#ifdef DEBUG
+  E->batch = false;
+#else
+  E->batch = gf_degree <= 8;
+#endif
+  E->sliced = E->batch && gf_degree <= 4;
+  E->hm = malloc(n * sizeof *E->hm);
+  E->T = NULL;
+  if (E->batch) {
+    E->T = malloc(q * nw * sizeof *E->T);
+    for (size_t i = 0; i < q * nw; ++i) {
+      unsigned quad = Q[i];
+      E->T[i] = (quad < 0xffffff ? quad : 0xffffff) | (uint32_t) kern_sym(V[i]) << 24;
+    }
+  }
+  const char *env = getenv("BESTPARITY_SORTED");
+  E->sorted = env != NULL && atoi(env) != 0;
+  E->neighbours = 0;
+  E->poolsize = 64;
+  E->pool = malloc(E->poolsize * (n + 4) * sizeof *E->pool);
+  E->bucket = malloc(qmax * sizeof *E->bucket);
+  E->Eb = malloc(n * KERN_BLOCK * sizeof *E->Eb);
+  E->Yb = malloc(n * KERN_BLOCK * sizeof *E->Yb);
+  E->qb = malloc(KERN_BLOCK * sizeof *E->qb);
+  E->sb = malloc(2 * KERN_BLOCK * sizeof *E->sb);
+  E->nb = 0;
+
+  /* Nombre d'incréments de poids w sans cappage, C(n, w)
+     (q-1)^w, pour compter ce que le cappage évite. */
+  E->nfull = malloc((n+1) * sizeof *E->nfull);
+  for (size_t w = 0; w <= n; ++w) {
+    unsigned long long c = 1;
+    for (size_t i = 0; i < w; ++i)
+      c = c * (n - i) / (i + 1) * (q - 1);
+    E->nfull[w] = c;
+  }
+}
+
+
+void ev_checks(struct evaluator *E, size_t r) {
+  if (r == 0 || r >= E->n)
+    error("Le nombre de parités doit être entre 1 et n-1.");
+  if (r * gf_degree > 64)
+    error("Trop de parités pour ranger les syndromes sur 64 bits.");
+  E->r = r;
+  E->hm = realloc(E->hm, pcm_size(E->n, r) * sizeof *E->hm);
+}
+
+
+void ev_free(struct evaluator *E) {
+  free(E->dcap);
+  free(E->Sinf);
+  free(E->x);
+  free(E->y);
+  free(E->qy);
+  free(E->hy);
+  free(E->da);
+  free(E->df);
+  free(E->ddir);
+  free(E->dp);
+  free(E->hm);
+  free(E->T);
+  free(E->Eb);
+  free(E->Yb);
+  free(E->qb);
+  free(E->sb);
+  free(E->nfull);
+  free(E->pool);
+  free(E->bucket);
+}
+
+
+/* Traite le lot de voisins en attente : symboles et
+   quadrances, puis syndromes, et enfin mise à jour du
+   spectre pour les voisins mots de code à bonne distance. */
+static void ev_flush(struct evaluator *E, unsigned long *S) {
+  size_t n = E->n;
+  size_t nb = E->nb;
+
+  memset(E->qb, 0, nb * sizeof *E->qb);
+  for (size_t i = 0; i < n; ++i)
+    kern->quadacc(E->qb, E->Yb + i * KERN_BLOCK, E->T, E->Eb + i * KERN_BLOCK, nb);
+
+  /* La ligne j porte sur les positions 0..k-1 et k+j : la
+     colonne k+j est recopiée en k une fois les lignes
+     précédentes traitées. */
+  const size_t k = n - E->r;
+  unsigned long long valid = 0;
+  if (E->sliced) {
+    uint64_t hit = ~0ull;
+    for (size_t j = 0; j < E->r; ++j) {
+      if (j > 0)
+        memcpy(E->Yb + k * KERN_BLOCK, E->Yb + (k + j) * KERN_BLOCK, nb);
+      hit &= kern->sliced(k + 1, E->hm + j * (k + 1), E->Yb, KERN_BLOCK, nb);
+    }
+    for (; hit != 0; hit &= hit - 1) {
+      unsigned quad = E->qb[__builtin_ctzll(hit)];
+      if (quad < E->qmax) {
+        valid++;
+        S[quad]++;
+      }
+    }
+  } else {
+    kern->syndromes(k + 1, E->hm, E->Yb, KERN_BLOCK, nb, E->sb);
+    for (size_t j = 1; j < E->r; ++j) {
+      uint8_t *sj = E->sb + KERN_BLOCK;
+      memcpy(E->Yb + k * KERN_BLOCK, E->Yb + (k + j) * KERN_BLOCK, nb);
+      kern->syndromes(k + 1, E->hm + j * (k + 1), E->Yb, KERN_BLOCK, nb, sj);
+      for (size_t l = 0; l < nb; ++l) E->sb[l] |= sj[l];
+    }
+    for (size_t l = 0; l < nb; ++l)
+      if (E->sb[l] == 0 && E->qb[l] < E->qmax) {
+        valid++;
+        S[E->qb[l]]++;
+      }
+  }
+
+#ifdef STATS
+  /* Comptés comme par le parcours scalaire : seuls les
+     voisins à quadrance inférieure à qmax sont des tests */
+  unsigned long long far = 0;
+  for (size_t l = 0; l < nb; ++l)
+    far += E->qb[l] >= E->qmax;
+  ST_ADD(ST_NEIGHBOURS, nb);
+  ST_ADD(ST_FAR, far);
+  ST_ADD(ST_CHECKS, nb - far);
+  ST_ADD(ST_VALID, valid);
+#endif
+  E->nb = 0;
+}
+
+
+/* ** Voisins par quadrance croissante
+ *
+ * Les incréments d forment un arbre : le père de d != 0 est
+ * d moins 1 en sa dernière position non nulle p, et les
+ * fils de d l'augmentent de 1 en une position j >= p. Les
+ * lignes de V étant triées, un fils n'est jamais plus
+ * proche que son père, et une fusion des n listes triées
+ * par une file de priorité sur la quadrance (comme pour
+ * l'énumération des k meilleures listes) donne les voisins
+ * dans l'ordre. Les quadrances étant des entiers inférieurs
+ * à qmax, la file est une file à seaux : une pile de
+ * sommets par quadrance. Un sommet est élagué avec tout son
+ * sous-arbre dès que sa quadrance plus le minimum restant
+ * (qmin au poids 1, 0 ensuite) atteint qmax. Les sommets
+ * de poids 0 et 1 ne sont pas des voisins utiles : ils ne
+ * servent qu'à atteindre les autres.
+ *
+ * Un sommet occupe n + 4 entiers de pool : suivant dans sa
+ * pile (ou dans la liste des sommets libres), quadrance,
+ * position p, poids, puis les n incréments.
+ */
+
+#define NS_NIL UINT_MAX
+
+static inline unsigned *ns_vertex(struct evaluator *E, unsigned k) {
+  return E->pool + (size_t) k * (E->n + 4);
+}
+
+
+static unsigned ns_alloc(struct evaluator *E) {
+  if (E->nsfree != NS_NIL) {
+    unsigned k = E->nsfree;
+    E->nsfree = ns_vertex(E, k)[0];
+    return k;
+  }
+  if (E->npool == E->poolsize) {
+    E->poolsize *= 2;
+    E->pool = realloc(E->pool, E->poolsize * (E->n + 4) * sizeof *E->pool);
+    if (E->pool == NULL)
+      error("Mémoire insuffisante pour le parcours des voisins.");
+  }
+  return E->npool++;
+}
+
+
+/* Ajoute au spectre S les voisins de x à quadrance
+   inférieure à qmax, par quadrance croissante. Retourne
+   false, sans finir, dès que S est moins bon que Sbest. */
+static bool ev_sorted(struct evaluator *E, const gf_elt *x,
+                      unsigned long *S, const unsigned long *Sbest) {
+  const size_t n = E->n, q = E->M->q, nw = E->M->w;
+  const unsigned qmax = E->qmax, qmin = E->M->qmin;
+  const unsigned *Q = E->M->Q;
+  const gf_elt *V = E->M->V;
+
+  unsigned *bucket = E->bucket;
+  E->npool = 0;
+  E->nsfree = NS_NIL;
+  for (unsigned l = 0; l < qmax; ++l) bucket[l] = NS_NIL;
+  unsigned k = ns_alloc(E);
+  memset(ns_vertex(E, k), 0, (n + 4) * sizeof *E->pool);
+  ns_vertex(E, k)[0] = NS_NIL;
+  bucket[0] = k;
+
+  for (unsigned level = 0; level < qmax; ) {
+    if (bucket[level] == NS_NIL) {
+      /* Niveau terminé : le spectre est à jour jusqu'à level */
+      if (E->batch && E->nb > 0)
+        ev_flush(E, S);
+      if (sp_cmp(Sbest, S, qmax) > 0)
+        return false;
+      ++level;
+      continue;
+    }
+    k = bucket[level];
+    unsigned *v = ns_vertex(E, k);
+    bucket[level] = v[0];
+    unsigned quad = v[1], p = v[2], w = v[3];
+
+    if (w >= 2) {
+      const unsigned *d = v + 4;
+      E->neighbours++;
+      if (E->batch) {
+        for (size_t i = 0; i < n; ++i)
+          E->Eb[i * KERN_BLOCK + E->nb] = x[i] * nw + d[i];
+        if (++E->nb == KERN_BLOCK)
+          ev_flush(E, S);
+      } else {
+        uint64_t syn = 0;
+        for (size_t i = 0; i < n; ++i)
+          syn ^= E->hy[i * q + V[x[i] * nw + d[i]]];
+        ST_ADD(ST_NEIGHBOURS, 1);
+        ST_ADD(ST_CHECKS, 1);
+        if (syn == 0) {
+          ST_ADD(ST_VALID, 1);
+          S[quad]++;
+        }
+      }
+    }
+
+    /* Fils */
+    for (size_t j = p; j < n; ++j) {
+      v = ns_vertex(E, k);
+      unsigned dj = v[4 + j];
+      if (dj + 1 == nw) continue;
+      const unsigned *Qx = Q + x[j] * nw;
+      unsigned cq = quad - Qx[dj] + Qx[dj + 1];
+      unsigned cw = w + (dj == 0);
+      if (cq >= qmax || (cw < 2 && cq + qmin >= qmax)) continue;
+
+      unsigned c = ns_alloc(E);
+      v = ns_vertex(E, k);
+      unsigned *u = ns_vertex(E, c);
+      memcpy(u + 4, v + 4, n * sizeof *u);
+      u[0] = bucket[cq];
+      u[1] = cq;
+      u[2] = j;
+      u[3] = cw;
+      u[4 + j] = dj + 1;
+      bucket[cq] = c;
+    }
+    ns_vertex(E, k)[0] = E->nsfree;
+    E->nsfree = k;
+  }
+  return true;
+}
+
+
+bool ev_spectrum(struct evaluator *E, const gf_elt *h,
+                 unsigned long *S, const unsigned long *Sbest) {
+  size_t n = E->n, r = E->r, k = n - r;
+  size_t q = E->M->q, nw = E->M->w;
+  unsigned qmax = E->qmax;
+  const unsigned *Q = E->M->Q;
+  const gf_elt *V = E->M->V;
+  gf_elt *x = E->x, *y = E->y;
+  unsigned *qy = E->qy;
+  const size_t *da = E->da;
+
+  if (Sbest == NULL)
+    Sbest = E->Sinf;
+
+  memset(S, 0, qmax * sizeof *S); /* RAZ du Spectre pour cette parité */
+  S[0] = 1UL << gf_degree * k; /* k <= n-1, cf. ev_init */
+
+  if (E->batch)
+    for (size_t i = 0; i < pcm_size(n, r); ++i)
+      gf_mul_init(E->hm + i, h[i]);
+  else {
+    /* Ligne j aux bits m j..m j+m-1 : A_j[i] y en i < k, y
+       en k+j */
+    memset(E->hy, 0, n * q * sizeof *E->hy);
+    for (size_t j = 0; j < r; ++j)
+      for (size_t v = 0; v < q; ++v) {
+        for (size_t i = 0; i < k; ++i) {
+          gf_elt t = gf_zero;
+          gf_accmul(&t, h[j * (k + 1) + i], v);
+          E->hy[i * q + v] |= (uint64_t) t << gf_degree * j;
+        }
+        E->hy[(k + j) * q + v] |= (uint64_t) v << gf_degree * j;
+      }
+  }
+  const uint64_t *hy = E->hy;
+  unsigned quad = 0;          /* Quadrance et syndromes de y */
+  uint64_t syn = 0;
+
+  /* Pour chaque mot de code x */
+  cw_begin(n, h, x);
+  unsigned long long ncw = 0;
+  do {
+    ncw++;
+    tr_poll();
+    if (E->sorted) {
+      bool more = ev_sorted(E, x, S, Sbest);
+      if (!more) break;
+      continue;
+    }
+
+    /* Boucles sur les voisins */
+    for (size_t dw = 2; S[2] <= Sbest[2] && dw <= n; dw++) {
+      /* Initialisation de delta */
+      nb_begin(E, dw);
+      const size_t *dm = E->dcap + dw * q;
+      unsigned long long visited = 0;
+
+      while(S[2] <= Sbest[2]) {
+        visited++;
+        if (E->batch) {
+          /* Le voisin est mis en attente dans le lot */
+          for (size_t i = 0; i < n; ++i)
+            E->Eb[i * KERN_BLOCK + E->nb] = x[i] * nw + da[i];
+          if (++E->nb == KERN_BLOCK)
+            ev_flush(E, S);
+        } else {
+          /* Récupère un mot de code à partir des incréments,
+             avec sa quadrance et son syndrome. Après un pas
+             du code de Gray, seule la position dchg change. */
+          if (E->dchg < 0) {
+            quad = 0;
+            syn = 0;
+            for (size_t i = 0; i < n; ++i) {
+              y[i] = V[x[i] * nw + da[i]];
+              qy[i] = Q[x[i] * nw + da[i]];
+              quad += qy[i];
+              syn ^= hy[i * q + y[i]];
+            }
+          } else {
+            size_t i = E->dchg;
+            gf_elt yi = V[x[i] * nw + da[i]];
+            unsigned qi = Q[x[i] * nw + da[i]];
+            quad += qi - qy[i];
+            syn ^= hy[i * q + y[i]] ^ hy[i * q + yi];
+            y[i] = yi;
+            qy[i] = qi;
+          }
+
+#ifdef DEBUG
+          printf("%c x:", syn == 0 ? '*' : ' ');
+          for (size_t i=0; i < n; ++i) printf(" %2u", x[i]);
+          printf("\ty:"); for (size_t i=0; i < n; ++i) printf(" %2u", y[i]);
+          printf("\td:"); for (size_t i=0; i < n; ++i) printf(" %2zu", da[i]);
+          printf("\tquad: %u, wt: %zu\t%c\n", quad, dw, quad < qmax ? ' ' : '>');
+#endif
+
+          /* Ici nous avons un voisin mot de code à bonne distance ! */
+          ST_ADD(ST_NEIGHBOURS, 1);
+          if (quad >= qmax)
+            ST_ADD(ST_FAR, 1);
+          else {
+            ST_ADD(ST_CHECKS, 1);
+            if (syn == 0) {
+              ST_ADD(ST_VALID, 1);
+              S[quad]++;
+            }
+          }
+        }
+
+        /* Voisin suivant */
+        if (!nb_next(E, dw, dm, x)) {
+          ST_ADD(ST_CAPPED, E->nfull[dw] - visited);
+          break;
+        }
+      }
+      E->neighbours += visited;
+    }
+
+    /* On vérifie aussi que le spectre courant reste meilleur que le meilleur jusqu'ici */
+  } while(pcm_cw_next(n, r, h, x) && sp_cmp(Sbest, S, qmax) <= 0); /* Mot de code suivant */
+
+  if (E->nb > 0)
+    ev_flush(E, S);
+  bool complete = sp_cmp(Sbest, S, qmax) <= 0;
+
+#ifdef STATS
+  ST_ADD(ST_PARITIES, 1);
+  ST_ADD(ST_CODEWORDS, ncw);
+  if (!complete) {
+    ST_ADD(ST_CUT, 1);
+    if (ncw == 1) ST_ADD(ST_CUT_FIRST, 1);
+  }
+  for (size_t i = 1; i < qmax; ++i)
+    ST_HIT(i, S[i]);
+#endif
+  return complete;
+}
+
+
+/* * Évaluation par lots
+ *
+ * Les tables dépendant du mapping et l'évaluateur ne sont
+ * construits qu'une fois pour tout le lot.
+ */
+void bp_evaluate(const struct mapping *M, size_t n,
+                 const gf_elt *H, size_t count,
+                 unsigned qmax, unsigned long *S) {
+  struct evaluator E;
+
+  ev_init(&E, M, n, qmax);
+  for (size_t k = 0; k < count; ++k)
+    ev_spectrum(&E, H + k * n, S + k * qmax, NULL);
+  ev_free(&E);
+}
@@ -0,0 +1,173 @@
+#include "bestparity.h"
+
+
+/* * Bibliothèque GF(2^m)
+ *
+ * La construction d'un corps fini repose sur un polynôme
+ * primitif. Voici une liste pour GF(2^m) pour les premières
+ * valeurs de m.
+ */
+
+
+/* Liste de polynômes primitifs pour construire GF(2^m) pour
+   m allant de 1 à 16. gf_init vérifie que chacun est bien
+   primitif.
+
+   |     q | P                              | P hexdécimal |
+   |-------+--------------------------------+--------------|
+   |     2 | X + 1                          |          0x3 |
+   |     4 | X^2 + X + 1                    |          0x7 |
+   |     8 | X^3 + X + 1                    |          0xb |
+   |    16 | X^4 + X + 1                    |         0x13 |
+   |    32 | X^5 + X^2 + 1                  |         0x25 |
+   |    64 | X^6 + X + 1                    |         0x43 |
+   |   128 | X^7 + X^3 + 1                  |         0x89 |
+   |   256 | X^8 + X^4 + X^3 + X^2 + 1      |        0x11d |
+   |   512 | X^9 + X^5 + 1                  |        0x221 |
+   |  1024 | X^10 + X^3 + 1                 |        0x409 |
+   |  2048 | X^11 + X^2 + 1                 |        0x805 |
+   |  4096 | X^12 + X^6 + X^4 + X + 1       |       0x1053 |
+   |  8192 | X^13 + X^4 + X^3 + X + 1       |       0x201b |
+   | 16384 | X^14 + X^10 + X^6 + X + 1      |       0x4443 |
+   | 32768 | X^15 + X + 1                   |       0x8003 |
+   | 65536 | X^16 + X^12 + X^3 + X + 1      |      0x1100b |
+ */
+const size_t max_degree = 16;
+const unsigned primitives[] = {0x1, 0x3, 0x7, 0xb, 0x13, 0x25,
+                               0x43, 0x89, 0x11d, 0x221, 0x409,
+                               0x805, 0x1053, 0x201b, 0x4443, 0x8003,
+                               0x1100b};
+
+
+/* ** Constantes */
+
+size_t gf_size;
+size_t gf_size_minus_1;
+size_t gf_degree;
+const gf_elt gf_zero = 0;
+const gf_elt gf_one = 1;
+gf_elt gf_alpha;
+
+int *gf_log;
+gf_elt *gf_exp;
+
+uint8_t *gf_to_aes;
+uint8_t *gf_from_aes;
+
+
+/* ** Isomorphisme vers le corps de l'AES
+ *
+ * Les instructions GFNI multiplient dans GF(256) construit
+ * sur X^8 + X^4 + X^3 + X + 1 (0x11b) alors que nous
+ * utilisons 0x11d. Les deux corps sont isomorphes : si beta
+ * est une racine de 0x11d dans le corps de l'AES, alors
+ * phi(sum x_k alpha^k) = sum x_k beta^k est un isomorphisme,
+ * linéaire sur les bits. Transporter les symboles et les
+ * coefficients par phi laisse les syndromes nuls
+ * exactement aux mêmes endroits.
+ */
+
+/* Produit dans le corps de l'AES */
+static unsigned aes_mul(unsigned a, unsigned b) {
+  unsigned p = 0;
+  for (; b; b >>= 1) {
+    if (b & 1) p ^= a;
+    a <<= 1;
+    if (a & 0x100) a ^= 0x11b;
+  }
+  return p;
+}
+
+
+static void gf_aes_init(unsigned P) {
+  /* Recherche d'une racine beta de P dans le corps de l'AES
+     par la méthode de Horner. */
+  unsigned beta;
+  for (beta = 2; beta < 256; ++beta) {
+    unsigned v = 0;
+    for (int k = 8; k >= 0; --k)
+      v = aes_mul(v, beta) ^ ((P >> k) & 1);
+    if (v == 0) break;
+  }
+  if (beta == 256)
+    error("gf_aes_init: pas de racine dans le corps de l'AES");
+
+  gf_to_aes = malloc(256 * sizeof *gf_to_aes);
+  gf_from_aes = malloc(256 * sizeof *gf_from_aes);
+  for (unsigned x = 0; x < 256; ++x) {
+    unsigned y = 0, b = 1;
+    for (int k = 0; k < 8; ++k, b = aes_mul(b, beta))
+      if (x >> k & 1) y ^= b;
+    gf_to_aes[x] = y;
+    gf_from_aes[y] = x;
+  }
+
+  /* Vérification du morphisme sur les générateurs */
+  for (unsigned x = 1; x < 256; ++x) {
+    gf_elt ax = gf_zero;
+    gf_accmul(&ax, 1, x);
+    if (gf_to_aes[ax] != aes_mul(gf_to_aes[gf_alpha], gf_to_aes[x]))
+      error("gf_aes_init: isomorphisme incorrect");
+  }
+}
+
+
+/* ** Initialisation et libération */
+
+/* Initialisation du corps fini GF(q) à partir d'un polynôme
+   primitif P qui est donné par sa représentation binaire.
+   Ainsi, pour GF(8), le polynôme P = X^3 + X + 1 se
+   représente par l'entier 11 en décimal c'est-à-dire 1011
+   en binaire.
+*/
+int gf_init(unsigned P) {
+  // Lecture de la taille en lisant le degré de P
+  gf_degree = 0;
+  for (unsigned p = P; p > 0; p >>= 1) gf_degree++;
+  gf_size = 1 << --gf_degree;
+  gf_size_minus_1 = gf_size - 1;
+
+  // Construction des tables de log et de puissances
+  gf_log = malloc(gf_size * sizeof *gf_log);
+  gf_exp = malloc(gf_size * sizeof *gf_exp); // Normalement gf_size_minus_1....
+  gf_log[gf_zero] = -1; // 0 n'est pas une puissance de alpha !
+
+  // x sur un unsigned : pour m = 16, 2 x ne tient plus
+  // dans un gf_elt avant la réduction par P
+  unsigned x = gf_one;
+  for (size_t k = 0; k < gf_size_minus_1; k++) {
+    if (k > 0 && x == gf_one)  // Soucis, alpha d'ordre k
+      error("gf_init: Corps fini incorrect: polynôme non primitif\n");
+    gf_log[x] = k;              // remplissage des tables
+    gf_exp[k] = x;
+    x <<= 1;                    // puissance suivante
+    if (x >= gf_size)
+      x ^= P;
+  }
+  gf_alpha = gf_size > 2 ? gf_exp[1] : gf_one; // élément primitif, 1 dans GF(2)
+
+  if (x != gf_one)             // Soucis, P pas irréductible
+    error("gf_init: Corps fini incorrect: polynôme non primitif\n");
+
+  if (gf_degree == 8)
+    gf_aes_init(P);
+
+  // Choix des noyaux de calcul, une fois pour toutes
+  kern_init(getenv("BESTPARITY_ISA"));
+
+  return 0;
+}
+
+
+/* Libération des ressources utilisées par le corps */
+int gf_free(void) {
+  free(gf_log);
+  free(gf_exp);
+  free(gf_to_aes);
+  free(gf_from_aes);
+  gf_log = NULL;
+  gf_exp = NULL;
+  gf_to_aes = NULL;
+  gf_from_aes = NULL;
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include "bestparity.h"
+
+
+/* * Lectures des fichiers */
+
+
+/* ** Constellation
+ *
+ * Un point par ligne, donné par ses deux coordonnées
+ * entières. La taille est lue au fil de l'eau en doublant
+ * le tableau à chaque puissance de 2.
+ */
+size_t const_read(const char *constfile, struct point **C, size_t *m) {
+  FILE *f;
+  size_t q = 0;
+
+  if (NULL == (f = fopen(constfile, "r")))
+    error("Impossible d'ouvrir le fichier constellation '%s'.", constfile);
+
+  *m = 0;
+  *C = malloc((1 << *m) * sizeof **C);
+  while (2 == fscanf(f, "%d%d", &(*C)[q].x, &(*C)[q].y))
+    if (++q == (1 << *m))
+      if (NULL == (*C = realloc(*C, (1 << ++*m) * sizeof **C)))
+        error("Allocation mémoire impossible.");
+  --*m;
+  fclose(f);
+
+  if (1 << *m != q) error("Corps de caractéristique 2 uniquement.");
+  if (*m > max_degree) error("Constellation trop grande : au plus 2^%zu points.", max_degree);
+  return q;
+}
+
+
+/* ** Mapping */
+bool map_read(FILE *f, size_t q, size_t *pi) {
+  for (size_t i = 0; i < q; ++i)
+    if (1 != fscanf(f, "%zu", pi + i)) {
+      if (i == 0) return false;
+      error("Fichier mapping incomplet\n");
+    } else if (pi[i] >= q)
+      error("Valeur de mapping hors bornes\n");
+  return true;
+}
+
+
+/* ** Parité */
+bool chk_read(FILE *f, size_t n, gf_elt *h) {
+  for (size_t i = 0; i < n; ++i) {
+    unsigned hi;
+    if (1 != fscanf(f, "%u", &hi))
+      return false;
+    h[i] = hi;
+  }
+
+  /* Remet la parité h sans perte de généralité sous la
+     forme h0 h1 ... 0 avec h0 >= h1 >=... >= 0 */
+  for (size_t i = 0; i < n; ++i)
+    for (size_t j = i+1; j < n; ++j)
+      if (h[i] < h[j]) {
+        gf_elt tmp = h[i];
+        h[i] = h[j];
+        h[j] = tmp;
+      }
+
+  for (size_t i = 0; i < n; ++i)
+    h[i] -= h[n-1];
+
+  return true;
+}
@@ -0,0 +1,720 @@
+#include <string.h>
+
+#include "bestparity.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERN_X86
+#include <immintrin.h>
+#endif
+
+
+/* * Noyaux de calcul
+ *
+ * Toutes les variantes d'un noyau calculent exactement la
+ * même chose : seule la largeur des registres change. Les
+ * variantes vectorielles traitent les restes avec la
+ * version scalaire.
+ *
+ * Les variantes sont compilées dans ce seul fichier grâce à
+ * l'attribut target de gcc, sans option -m particulière :
+ * le binaire reste exécutable sur tous les processeurs x86
+ * et seule la variante choisie à l'exécution utilise des
+ * instructions récentes.
+ */
+
+
+/* ** Multiplication par une constante */
+
+void gf_mul_init(struct gf_mul *c, int hlog) {
+  gf_elt prod[8] = {0};
+
+  memset(c, 0, sizeof *c);
+  for (gf_elt i = 0; i < 16; ++i) {
+    gf_elt lo = 0, hi = 0;
+    if (i < gf_size) gf_accmul(&lo, hlog, i);
+    if ((i << 4) < gf_size) gf_accmul(&hi, hlog, i << 4);
+    c->lo[i] = lo;
+    c->hi[i] = hi;
+  }
+
+  /* Le bit i du produit est la parité des bits de x masqués
+     par la ligne i ; gf2p8affineqb range la ligne i dans
+     l'octet 7-i. */
+  for (size_t k = 0; k < gf_degree && k < 8; ++k)
+    gf_accmul(prod + k, hlog, 1 << k);
+  for (size_t i = 0; i < 8; ++i) {
+    uint64_t row = 0;
+    for (size_t k = 0; k < 8; ++k)
+      row |= (uint64_t) ((prod[k] >> i) & 1) << k;
+    c->affine |= row << (8 * (7 - i));
+  }
+
+  /* Le même coefficient dans la base de l'AES */
+  if (gf_to_aes != NULL) {
+    gf_elt a = gf_zero;
+    gf_accmul(&a, hlog, gf_one);
+    c->aes = gf_to_aes[a];
+  }
+}
+
+
+/* ** Variante scalaire */
+
+static void mulacc_scalar(uint8_t *acc, const struct gf_mul *c,
+                          const uint8_t *x, size_t len) {
+  for (size_t k = 0; k < len; ++k)
+    acc[k] ^= c->lo[x[k] & 15] ^ c->hi[x[k] >> 4];
+}
+
+
+static void syndromes_scalar(size_t n, const struct gf_mul *h,
+                             const uint8_t *Y, size_t stride,
+                             size_t count, uint8_t *s) {
+  memcpy(s, Y + (n-1) * stride, count);
+  for (size_t i = 0; i < n-1; ++i)
+    mulacc_scalar(s, h + i, Y + i * stride, count);
+}
+
+
+static void quadacc_scalar(unsigned *acc, uint8_t *y, const uint32_t *T,
+                           const uint16_t *e, size_t count) {
+  for (size_t k = 0; k < count; ++k) {
+    uint32_t t = T[e[k]];
+    acc[k] += t & 0xffffff;
+    y[k] = t >> 24;
+  }
+}
+
+
+/* Ajoute à syn les m tranches de h y, où plane porte les m
+   tranches de y : le bit r de h y est la somme des bits j
+   de y tels que le bit j de la ligne r de la matrice soit
+   levé. */
+static inline void sliced_net(size_t m, uint64_t affine, const uint64_t *plane,
+                              uint64_t *syn) {
+  for (size_t r = 0; r < m; ++r) {
+    unsigned row = affine >> (8 * (7 - r)) & 0xff;
+    uint64_t s = 0;
+    for (size_t j = 0; j < m; ++j)
+      if (row >> j & 1) s ^= plane[j];
+    syn[r] ^= s;
+  }
+}
+
+
+static inline uint64_t sliced_zero(size_t m, const uint64_t *syn, size_t count) {
+  uint64_t nz = 0;
+  for (size_t r = 0; r < m; ++r) nz |= syn[r];
+  return ~nz & (count >= 64 ? ~0ull : (1ull << count) - 1);
+}
+
+
+/* Les variantes sont spécialisées pour m = 2 et m = 4, où
+   les boucles du réseau se déroulent entièrement. */
+#define SLICED_DISPATCH(name)                                           \
+  static uint64_t name(size_t n, const struct gf_mul *h,                \
+                       const uint8_t *Y, size_t stride, size_t count) { \
+    switch (gf_degree) {                                                \
+    case 2: return name##_m(2, n, h, Y, stride, count);                 \
+    case 4: return name##_m(4, n, h, Y, stride, count);                 \
+    default: return name##_m(gf_degree, n, h, Y, stride, count);        \
+    }                                                                   \
+  }
+
+
+static inline uint64_t sliced_scalar_m(size_t m, size_t n, const struct gf_mul *h,
+                                       const uint8_t *Y, size_t stride, size_t count) {
+  uint64_t syn[4] = {0}, plane[4];
+  for (size_t i = 0; i < n; ++i) {
+    memset(plane, 0, sizeof plane);
+    for (size_t k = 0; k < count; ++k)
+      for (size_t j = 0; j < m; ++j)
+        plane[j] |= (uint64_t) (Y[i * stride + k] >> j & 1) << k;
+    if (i < n-1)
+      sliced_net(m, h[i].affine, plane, syn);
+    else
+      for (size_t j = 0; j < m; ++j) syn[j] ^= plane[j];
+  }
+  return sliced_zero(m, syn, count);
+}
+
+SLICED_DISPATCH(sliced_scalar)
+
+
+static int spcmp_scalar(const unsigned long *a, const unsigned long *b,
+                        unsigned qmax) {
+  for (size_t i = 2; i < qmax; ++i) /* On commence à d=2 */
+    if (a[i] == b[i])
+      continue;
+    else
+      return (b[i] > a[i]) ? 1 : -1;
+  return 0;
+}
+
+
+/* Termine une comparaison de spectres à partir de l'indice
+   i, utilisée par les variantes vectorielles. */
+static inline int spcmp_tail(const unsigned long *a, const unsigned long *b,
+                             size_t i, unsigned qmax) {
+  for (; i < qmax; ++i)
+    if (a[i] != b[i])
+      return (b[i] > a[i]) ? 1 : -1;
+  return 0;
+}
+
+
+static void lanes_scalar(const uint8_t *base, const uint8_t *T, const gf_elt *c,
+                         size_t count, const uint8_t *tgt, const uint8_t *msk,
+                         size_t ntgt, uint8_t *cnt) {
+  for (size_t j = 0; j < count; ++j) {
+    const uint8_t *t = T + c[j] * KERN_LANES;
+    for (size_t l = 0; l < KERN_LANES; ++l) {
+      uint8_t y = base[l] ^ t[l], hit = 0;
+      for (size_t k = 0; k < ntgt; ++k)
+        hit |= (y == tgt[k * KERN_LANES + l]) & (msk[k * KERN_LANES + l] != 0);
+      cnt[l] += hit;
+    }
+  }
+}
+
+
+static const struct kernels kern_scalar = {
+  "scalar", false, mulacc_scalar, syndromes_scalar, quadacc_scalar, spcmp_scalar,
+  lanes_scalar, sliced_scalar
+};
+
+
+#ifdef KERN_X86
+
+/* ** Variante SSE4.2
+ *
+ * Multiplication par pshufb sur les deux quartets de chaque
+ * octet, 16 symboles à la fois.
+ */
+
+__attribute__((target("sse4.2")))
+static inline __m128i mul_sse(__m128i x, __m128i tlo, __m128i thi) {
+  __m128i m = _mm_set1_epi8(0x0f);
+  __m128i lo = _mm_shuffle_epi8(tlo, _mm_and_si128(x, m));
+  __m128i hi = _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi16(x, 4), m));
+  return _mm_xor_si128(lo, hi);
+}
+
+
+__attribute__((target("sse4.2")))
+static void mulacc_sse(uint8_t *acc, const struct gf_mul *c,
+                       const uint8_t *x, size_t len) {
+  __m128i tlo = _mm_loadu_si128((const __m128i *) c->lo);
+  __m128i thi = _mm_loadu_si128((const __m128i *) c->hi);
+  size_t k;
+  for (k = 0; k + 16 <= len; k += 16) {
+    __m128i a = _mm_loadu_si128((__m128i *) (acc + k));
+    __m128i v = _mm_loadu_si128((const __m128i *) (x + k));
+    _mm_storeu_si128((__m128i *) (acc + k), _mm_xor_si128(a, mul_sse(v, tlo, thi)));
+  }
+  mulacc_scalar(acc + k, c, x + k, len - k);
+}
+
+
+__attribute__((target("sse4.2")))
+static void syndromes_sse(size_t n, const struct gf_mul *h,
+                          const uint8_t *Y, size_t stride,
+                          size_t count, uint8_t *s) {
+  size_t k;
+  for (k = 0; k + 16 <= count; k += 16) {
+    __m128i acc = _mm_loadu_si128((const __m128i *) (Y + (n-1) * stride + k));
+    for (size_t i = 0; i < n-1; ++i) {
+      __m128i tlo = _mm_loadu_si128((const __m128i *) h[i].lo);
+      __m128i thi = _mm_loadu_si128((const __m128i *) h[i].hi);
+      __m128i v = _mm_loadu_si128((const __m128i *) (Y + i * stride + k));
+      acc = _mm_xor_si128(acc, mul_sse(v, tlo, thi));
+    }
+    _mm_storeu_si128((__m128i *) (s + k), acc);
+  }
+  if (k < count)
+    syndromes_scalar(n, h, Y + k, stride, count - k, s + k);
+}
+
+
+__attribute__((target("sse4.2")))
+static int spcmp_sse(const unsigned long *a, const unsigned long *b,
+                     unsigned qmax) {
+  size_t i;
+  for (i = 2; i + 2 <= qmax; i += 2) {
+    __m128i va = _mm_loadu_si128((const __m128i *) (a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i *) (b + i));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi64(va, vb)) != 0xffff)
+      break;
+  }
+  return spcmp_tail(a, b, i, qmax);
+}
+
+
+/* Les cibles sont comparées à y en parallèle ; une cible
+   atteinte donne -1 dans son octet, soustrait du compteur. */
+__attribute__((target("sse4.2")))
+static void lanes_sse(const uint8_t *base, const uint8_t *T, const gf_elt *c,
+                      size_t count, const uint8_t *tgt, const uint8_t *msk,
+                      size_t ntgt, uint8_t *cnt) {
+  for (size_t h = 0; h < KERN_LANES; h += 16) {
+    __m128i b = _mm_loadu_si128((const __m128i *) (base + h));
+    __m128i acc = _mm_loadu_si128((const __m128i *) (cnt + h));
+    for (size_t j = 0; j < count; ++j) {
+      __m128i y = _mm_xor_si128(b, _mm_loadu_si128((const __m128i *) (T + c[j] * KERN_LANES + h)));
+      __m128i hit = _mm_setzero_si128();
+      for (size_t k = 0; k < ntgt; ++k) {
+        __m128i t = _mm_loadu_si128((const __m128i *) (tgt + k * KERN_LANES + h));
+        __m128i m = _mm_loadu_si128((const __m128i *) (msk + k * KERN_LANES + h));
+        hit = _mm_or_si128(hit, _mm_and_si128(_mm_cmpeq_epi8(y, t), m));
+      }
+      acc = _mm_sub_epi8(acc, hit);
+    }
+    _mm_storeu_si128((__m128i *) (cnt + h), acc);
+  }
+}
+
+
+/* Tranche j : movemask du bit 7 de chaque octet après un
+   décalage de 7 - j. */
+__attribute__((target("sse4.2")))
+static inline uint64_t sliced_sse_m(size_t m, size_t n, const struct gf_mul *h,
+                                    const uint8_t *Y, size_t stride, size_t count) {
+  uint64_t syn[4] = {0}, plane[4];
+  for (size_t i = 0; i < n; ++i) {
+    __m128i v[4];
+    for (size_t b = 0; b < 4; ++b)
+      v[b] = _mm_loadu_si128((const __m128i *) (Y + i * stride + 16 * b));
+    for (size_t j = 0; j < m; ++j) {
+      plane[j] = 0;
+      for (size_t b = 0; b < 4; ++b)
+        plane[j] |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_slli_epi16(v[b], 7 - j)) << 16 * b;
+    }
+    if (i < n-1)
+      sliced_net(m, h[i].affine, plane, syn);
+    else
+      for (size_t j = 0; j < m; ++j) syn[j] ^= plane[j];
+  }
+  return sliced_zero(m, syn, count);
+}
+
+__attribute__((target("sse4.2")))
+SLICED_DISPATCH(sliced_sse)
+
+
+static const struct kernels kern_sse = {
+  "sse4.2", false, mulacc_sse, syndromes_sse, quadacc_scalar, spcmp_sse,
+  lanes_sse, sliced_sse
+};
+
+
+/* ** Variante AVX2
+ *
+ * 32 symboles à la fois, quadrances par vpgatherdd.
+ */
+
+__attribute__((target("avx2")))
+static inline __m256i mul_avx2(__m256i x, __m256i tlo, __m256i thi) {
+  __m256i m = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_shuffle_epi8(tlo, _mm256_and_si256(x, m));
+  __m256i hi = _mm256_shuffle_epi8(thi, _mm256_and_si256(_mm256_srli_epi16(x, 4), m));
+  return _mm256_xor_si256(lo, hi);
+}
+
+
+__attribute__((target("avx2")))
+static void mulacc_avx2(uint8_t *acc, const struct gf_mul *c,
+                        const uint8_t *x, size_t len) {
+  __m256i tlo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) c->lo));
+  __m256i thi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) c->hi));
+  size_t k;
+  for (k = 0; k + 32 <= len; k += 32) {
+    __m256i a = _mm256_loadu_si256((__m256i *) (acc + k));
+    __m256i v = _mm256_loadu_si256((const __m256i *) (x + k));
+    _mm256_storeu_si256((__m256i *) (acc + k), _mm256_xor_si256(a, mul_avx2(v, tlo, thi)));
+  }
+  mulacc_scalar(acc + k, c, x + k, len - k);
+}
+
+
+__attribute__((target("avx2")))
+static void syndromes_avx2(size_t n, const struct gf_mul *h,
+                           const uint8_t *Y, size_t stride,
+                           size_t count, uint8_t *s) {
+  size_t k;
+  for (k = 0; k + 32 <= count; k += 32) {
+    __m256i acc = _mm256_loadu_si256((const __m256i *) (Y + (n-1) * stride + k));
+    for (size_t i = 0; i < n-1; ++i) {
+      __m256i tlo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) h[i].lo));
+      __m256i thi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) h[i].hi));
+      __m256i v = _mm256_loadu_si256((const __m256i *) (Y + i * stride + k));
+      acc = _mm256_xor_si256(acc, mul_avx2(v, tlo, thi));
+    }
+    _mm256_storeu_si256((__m256i *) (s + k), acc);
+  }
+  if (k < count)
+    syndromes_scalar(n, h, Y + k, stride, count - k, s + k);
+}
+
+
+__attribute__((target("avx2")))
+static void quadacc_avx2(unsigned *acc, uint8_t *y, const uint32_t *T,
+                         const uint16_t *e, size_t count) {
+  const __m256i mask = _mm256_set1_epi32(0xffffff);
+  /* Ramène l'octet de poids fort de chaque mot en tête de
+     chaque moitié, puis les deux moitiés côte à côte. */
+  const __m256i pick = _mm256_setr_epi8(3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        3, 7, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i join = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+  size_t k;
+  for (k = 0; k + 8 <= count; k += 8) {
+    __m256i idx = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (e + k)));
+    __m256i t = _mm256_i32gather_epi32((const int *) T, idx, 4);
+    __m256i a = _mm256_loadu_si256((__m256i *) (acc + k));
+    _mm256_storeu_si256((__m256i *) (acc + k), _mm256_add_epi32(a, _mm256_and_si256(t, mask)));
+    __m256i b = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(t, pick), join);
+    _mm_storel_epi64((__m128i *) (y + k), _mm256_castsi256_si128(b));
+  }
+  quadacc_scalar(acc + k, y + k, T, e + k, count - k);
+}
+
+
+__attribute__((target("avx2")))
+static int spcmp_avx2(const unsigned long *a, const unsigned long *b,
+                      unsigned qmax) {
+  size_t i;
+  for (i = 2; i + 4 <= qmax; i += 4) {
+    __m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *) (b + i));
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(va, vb)) != -1)
+      break;
+  }
+  return spcmp_tail(a, b, i, qmax);
+}
+
+
+/* Un lot complet de parités par registre. Les variantes
+   AVX-512 s'en servent aussi : un lot plus large ne
+   réduirait pas le nombre de passages. */
+__attribute__((target("avx2")))
+static void lanes_avx2(const uint8_t *base, const uint8_t *T, const gf_elt *c,
+                       size_t count, const uint8_t *tgt, const uint8_t *msk,
+                       size_t ntgt, uint8_t *cnt) {
+  __m256i b = _mm256_loadu_si256((const __m256i *) base);
+  __m256i acc = _mm256_loadu_si256((const __m256i *) cnt);
+  for (size_t j = 0; j < count; ++j) {
+    __m256i y = _mm256_xor_si256(b, _mm256_loadu_si256((const __m256i *) (T + c[j] * KERN_LANES)));
+    __m256i hit = _mm256_setzero_si256();
+    for (size_t k = 0; k < ntgt; ++k) {
+      __m256i t = _mm256_loadu_si256((const __m256i *) (tgt + k * KERN_LANES));
+      __m256i m = _mm256_loadu_si256((const __m256i *) (msk + k * KERN_LANES));
+      hit = _mm256_or_si256(hit, _mm256_and_si256(_mm256_cmpeq_epi8(y, t), m));
+    }
+    acc = _mm256_sub_epi8(acc, hit);
+  }
+  _mm256_storeu_si256((__m256i *) cnt, acc);
+}
+
+
+__attribute__((target("avx2")))
+static inline uint64_t sliced_avx2_m(size_t m, size_t n, const struct gf_mul *h,
+                                     const uint8_t *Y, size_t stride, size_t count) {
+  uint64_t syn[4] = {0}, plane[4];
+  for (size_t i = 0; i < n; ++i) {
+    __m256i lo = _mm256_loadu_si256((const __m256i *) (Y + i * stride));
+    __m256i hi = _mm256_loadu_si256((const __m256i *) (Y + i * stride + 32));
+    for (size_t j = 0; j < m; ++j)
+      plane[j] = (uint32_t) _mm256_movemask_epi8(_mm256_slli_epi16(lo, 7 - j))
+        | (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_slli_epi16(hi, 7 - j)) << 32;
+    if (i < n-1)
+      sliced_net(m, h[i].affine, plane, syn);
+    else
+      for (size_t j = 0; j < m; ++j) syn[j] ^= plane[j];
+  }
+  return sliced_zero(m, syn, count);
+}
+
+__attribute__((target("avx2")))
+SLICED_DISPATCH(sliced_avx2)
+
+
+static const struct kernels kern_avx2 = {
+  "avx2", false, mulacc_avx2, syndromes_avx2, quadacc_avx2, spcmp_avx2,
+  lanes_avx2, sliced_avx2
+};
+
+
+/* ** Variante AVX-512
+ *
+ * 64 symboles à la fois, soit un lot complet par registre.
+ */
+
+#define KERN_AVX512 "avx512f,avx512bw"
+
+__attribute__((target(KERN_AVX512)))
+static inline __m512i mul_avx512(__m512i x, __m512i tlo, __m512i thi) {
+  __m512i m = _mm512_set1_epi8(0x0f);
+  __m512i lo = _mm512_shuffle_epi8(tlo, _mm512_and_si512(x, m));
+  __m512i hi = _mm512_shuffle_epi8(thi, _mm512_and_si512(_mm512_srli_epi16(x, 4), m));
+  return _mm512_xor_si512(lo, hi);
+}
+
+
+__attribute__((target(KERN_AVX512)))
+static void mulacc_avx512(uint8_t *acc, const struct gf_mul *c,
+                          const uint8_t *x, size_t len) {
+  __m512i tlo = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) c->lo));
+  __m512i thi = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) c->hi));
+  size_t k;
+  for (k = 0; k + 64 <= len; k += 64) {
+    __m512i a = _mm512_loadu_si512(acc + k);
+    __m512i v = _mm512_loadu_si512(x + k);
+    _mm512_storeu_si512(acc + k, _mm512_xor_si512(a, mul_avx512(v, tlo, thi)));
+  }
+  mulacc_scalar(acc + k, c, x + k, len - k);
+}
+
+
+__attribute__((target(KERN_AVX512)))
+static void syndromes_avx512(size_t n, const struct gf_mul *h,
+                             const uint8_t *Y, size_t stride,
+                             size_t count, uint8_t *s) {
+  size_t k;
+  for (k = 0; k + 64 <= count; k += 64) {
+    __m512i acc = _mm512_loadu_si512(Y + (n-1) * stride + k);
+    for (size_t i = 0; i < n-1; ++i) {
+      __m512i tlo = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) h[i].lo));
+      __m512i thi = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) h[i].hi));
+      __m512i v = _mm512_loadu_si512(Y + i * stride + k);
+      acc = _mm512_xor_si512(acc, mul_avx512(v, tlo, thi));
+    }
+    _mm512_storeu_si512(s + k, acc);
+  }
+  if (k < count)
+    syndromes_scalar(n, h, Y + k, stride, count - k, s + k);
+}
+
+
+__attribute__((target(KERN_AVX512)))
+static void quadacc_avx512(unsigned *acc, uint8_t *y, const uint32_t *T,
+                           const uint16_t *e, size_t count) {
+  const __m512i mask = _mm512_set1_epi32(0xffffff);
+  size_t k;
+  for (k = 0; k + 16 <= count; k += 16) {
+    __m512i idx = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *) (e + k)));
+    __m512i t = _mm512_i32gather_epi32(idx, (const int *) T, 4);
+    __m512i a = _mm512_loadu_si512(acc + k);
+    _mm512_storeu_si512(acc + k, _mm512_add_epi32(a, _mm512_and_si512(t, mask)));
+    _mm_storeu_si128((__m128i *) (y + k), _mm512_cvtepi32_epi8(_mm512_srli_epi32(t, 24)));
+  }
+  quadacc_scalar(acc + k, y + k, T, e + k, count - k);
+}
+
+
+__attribute__((target(KERN_AVX512)))
+static int spcmp_avx512(const unsigned long *a, const unsigned long *b,
+                        unsigned qmax) {
+  size_t i;
+  for (i = 2; i + 8 <= qmax; i += 8) {
+    __m512i va = _mm512_loadu_si512(a + i);
+    __m512i vb = _mm512_loadu_si512(b + i);
+    if (_mm512_cmpneq_epu64_mask(va, vb))
+      break;
+  }
+  return spcmp_tail(a, b, i, qmax);
+}
+
+
+/* Une tranche de 64 voisins par vptestmb. */
+__attribute__((target(KERN_AVX512)))
+static inline uint64_t sliced_avx512_m(size_t m, size_t n, const struct gf_mul *h,
+                                       const uint8_t *Y, size_t stride, size_t count) {
+  uint64_t syn[4] = {0}, plane[4];
+  for (size_t i = 0; i < n; ++i) {
+    __m512i v = _mm512_loadu_si512(Y + i * stride);
+    for (size_t j = 0; j < m; ++j)
+      plane[j] = _mm512_test_epi8_mask(v, _mm512_set1_epi8(1 << j));
+    if (i < n-1)
+      sliced_net(m, h[i].affine, plane, syn);
+    else
+      for (size_t j = 0; j < m; ++j) syn[j] ^= plane[j];
+  }
+  return sliced_zero(m, syn, count);
+}
+
+__attribute__((target(KERN_AVX512)))
+SLICED_DISPATCH(sliced_avx512)
+
+
+static const struct kernels kern_avx512 = {
+  "avx512", false, mulacc_avx512, syndromes_avx512, quadacc_avx512, spcmp_avx512,
+  lanes_avx2, sliced_avx512
+};
+
+
+/* ** Variante GFNI
+ *
+ * La multiplication par une constante est une application
+ * GF(2)-linéaire sur les bits du symbole : une seule
+ * instruction gf2p8affineqb la calcule pour 64 symboles,
+ * quel que soit le polynôme primitif.
+ */
+
+#define KERN_GFNI "avx512f,avx512bw,gfni"
+
+__attribute__((target(KERN_GFNI)))
+static void mulacc_gfni(uint8_t *acc, const struct gf_mul *c,
+                        const uint8_t *x, size_t len) {
+  __m512i A = _mm512_set1_epi64(c->affine);
+  size_t k;
+  for (k = 0; k + 64 <= len; k += 64) {
+    __m512i a = _mm512_loadu_si512(acc + k);
+    __m512i v = _mm512_loadu_si512(x + k);
+    _mm512_storeu_si512(acc + k, _mm512_xor_si512(a, _mm512_gf2p8affine_epi64_epi8(v, A, 0)));
+  }
+  mulacc_scalar(acc + k, c, x + k, len - k);
+}
+
+
+__attribute__((target(KERN_GFNI)))
+static void syndromes_gfni(size_t n, const struct gf_mul *h,
+                           const uint8_t *Y, size_t stride,
+                           size_t count, uint8_t *s) {
+  size_t k;
+  for (k = 0; k + 64 <= count; k += 64) {
+    __m512i acc = _mm512_loadu_si512(Y + (n-1) * stride + k);
+    for (size_t i = 0; i < n-1; ++i) {
+      __m512i v = _mm512_loadu_si512(Y + i * stride + k);
+      acc = _mm512_xor_si512(acc, _mm512_gf2p8affine_epi64_epi8(v, _mm512_set1_epi64(h[i].affine), 0));
+    }
+    _mm512_storeu_si512(s + k, acc);
+  }
+  if (k < count)
+    syndromes_scalar(n, h, Y + k, stride, count - k, s + k);
+}
+
+
+static const struct kernels kern_gfni = {
+  "gfni", false, mulacc_gfni, syndromes_gfni, quadacc_avx512, spcmp_avx512,
+  lanes_avx2, sliced_avx512
+};
+
+
+/* ** Variante GFNI pour GF(256)
+ *
+ * Pour m = 8, gf2p8mulb multiplie directement 64 paires de
+ * symboles, mais dans le corps de l'AES : symboles et
+ * coefficients sont alors donnés dans cette base (cf.
+ * gf_to_aes). Les restes sont traités par des chargements
+ * masqués puisque la version scalaire ne connaît pas cette
+ * base.
+ */
+
+__attribute__((target(KERN_GFNI)))
+static void mulacc_gfni_aes(uint8_t *acc, const struct gf_mul *c,
+                            const uint8_t *x, size_t len) {
+  __m512i C = _mm512_set1_epi8(c->aes);
+  for (size_t k = 0; k < len; k += 64) {
+    __mmask64 r = len - k >= 64 ? ~(__mmask64) 0 : ((__mmask64) 1 << (len - k)) - 1;
+    __m512i a = _mm512_maskz_loadu_epi8(r, acc + k);
+    __m512i v = _mm512_maskz_loadu_epi8(r, x + k);
+    _mm512_mask_storeu_epi8(acc + k, r, _mm512_xor_si512(a, _mm512_gf2p8mul_epi8(v, C)));
+  }
+}
+
+
+__attribute__((target(KERN_GFNI)))
+static void syndromes_gfni_aes(size_t n, const struct gf_mul *h,
+                               const uint8_t *Y, size_t stride,
+                               size_t count, uint8_t *s) {
+  for (size_t k = 0; k < count; k += 64) {
+    __mmask64 r = count - k >= 64 ? ~(__mmask64) 0 : ((__mmask64) 1 << (count - k)) - 1;
+    __m512i acc = _mm512_maskz_loadu_epi8(r, Y + (n-1) * stride + k);
+    for (size_t i = 0; i < n-1; ++i) {
+      __m512i v = _mm512_maskz_loadu_epi8(r, Y + i * stride + k);
+      acc = _mm512_xor_si512(acc, _mm512_gf2p8mul_epi8(v, _mm512_set1_epi8(h[i].aes)));
+    }
+    _mm512_mask_storeu_epi8(s + k, r, acc);
+  }
+}
+
+
+static const struct kernels kern_gfni_aes = {
+  "gfni", true, mulacc_gfni_aes, syndromes_gfni_aes, quadacc_avx512, spcmp_avx512,
+  lanes_avx2, sliced_avx512
+};
+
+#endif /* KERN_X86 */
+
+
+/* ** Choix de la variante */
+
+const struct kernels *kern = &kern_scalar;
+
+
+/* Indique si le processeur sait exécuter la variante K. */
+static bool kern_supported(const struct kernels *K) {
+  if (K == &kern_scalar)
+    return true;
+#ifdef KERN_X86
+  __builtin_cpu_init();
+  if (K == &kern_sse)
+    return __builtin_cpu_supports("sse4.2");
+  if (K == &kern_avx2)
+    return __builtin_cpu_supports("avx2");
+  if (K == &kern_avx512)
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+  if (K == &kern_gfni)
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+      && __builtin_cpu_supports("gfni");
+#endif
+  return false;
+}
+
+
+/* Installe la variante K, en passant par la base de l'AES
+   quand le corps le permet. */
+static const struct kernels *kern_field(const struct kernels *K) {
+#ifdef KERN_X86
+  if (K == &kern_gfni && gf_to_aes != NULL)
+    K = &kern_gfni_aes;
+#endif
+  return kern = K;
+}
+
+
+/* Par ordre de préférence */
+static const struct kernels *all[] = {
+#ifdef KERN_X86
+  &kern_gfni, &kern_avx512, &kern_avx2, &kern_sse,
+#endif
+  &kern_scalar
+};
+static const size_t nall = sizeof all / sizeof *all;
+
+
+size_t kern_list(const char **names) {
+  size_t k = 0;
+  for (size_t i = 0; i < nall; ++i)
+    if (kern_supported(all[i]))
+      names[k++] = all[i]->name;
+  return k;
+}
+
+
+const struct kernels *kern_init(const char *name) {
+
+  if (name == NULL || *name == '\0') {
+    for (size_t i = 0; i < nall; ++i)
+      if (kern_supported(all[i]))
+        return kern_field(all[i]);
+  }
+
+  for (size_t i = 0; i < nall; ++i)
+    if (strcmp(name, all[i]->name) == 0) {
+      if (!kern_supported(all[i]))
+        error("Variante '%s' non supportée par ce processeur.", name);
+      return kern_field(all[i]);
+    }
+
+  error("Variante inconnue '%s' (scalar, sse4.2, avx2, avx512, gfni).", name);
+}
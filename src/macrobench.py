@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+# * Macrobenchmarks
+#
+# Mesure de bout en bout de best-parity, spectra et crible
+# sur une matrice (constellation, n, qmax ou quad, nombre de
+# processus). Les programmes ne sont pas multi-threadés : le
+# parallélisme est celui de bin/, c'est-à-dire plusieurs
+# processus lancés de front.
+#
+# - crible : la liste de parités est répartie entre les P
+#   processus, le travail total est fixe (passage à
+#   l'échelle fort, efficacité T1 / (P TP)) ;
+# - best-parity et spectra : chaque processus traite son
+#   propre mapping, le travail croît avec P (passage à
+#   l'échelle faible, efficacité T1 / TP).
+#
+# Pour chaque case sont relevés le temps réel, les débits
+# en parités, mots de code et voisins (d'après la ligne
+# « effort: » que chaque programme écrit sur stderr avec une
+# construction -DSTATS, comme celle de make bench-macro ;
+# vides sinon, le temps réel restant comparable) et
+# le pic de mémoire résidente du plus gros processus. Le
+# résultat est un CSV et un tableau.
+#
+# Usage
+#   ./macrobench.py [-t 1,2,4] [-o macro.csv] [-r REPEAT] [filtre]
+#
+# filtre restreint la matrice aux cas dont le nom le
+# contient (par exemple crible ou 64-QAM).
+
+import argparse
+import csv
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DATA = os.path.join(HERE, '..', 'data')
+
+
+# ** La matrice
+#
+# (programme, constellation, fichier de mappings, n,
+#  paramètre, parités pour crible)
+
+def parities_head(path, count):
+    with open(os.path.join(DATA, path)) as f:
+        return [line for _, line in zip(range(count), f)]
+
+
+def parities_combinations(k, q, count):
+    p = subprocess.Popen([os.path.join(HERE, 'combinations'), str(k), str(q)],
+                         stdout=subprocess.PIPE, text=True)
+    hs = [line for _, line in zip(range(count), p.stdout)]
+    p.kill()
+    p.wait()
+    return hs
+
+
+def matrix():
+    return [
+        ('best-parity', '4-QAM', '4-DVB.txt', 3, 12, None),
+        ('best-parity', '16-QAM', 'All24_16-QAM.txt', 3, 16, None),
+        ('spectra', '4-QAM', '4-DVB.txt', 3, 5, None),
+        ('spectra', '16-QAM', 'All24_16-QAM.txt', 3, 6, None),
+        ('crible', '16-QAM', '16-DVB.txt', 4, 4, parities_head('H4-16.txt', 100)),
+        ('crible', '64-QAM', '64-DVB.txt', 3, 4, parities_combinations(3, 64, 300)),
+        ('crible', '64-QAM', '64-DVB.txt', 4, 4, parities_head('H4-64.txt', 2)),
+        ('crible', '256-QAM', '256-DVB.txt', 3, 4, parities_combinations(3, 256, 20)),
+    ]
+
+
+def read_mappings(path):
+    with open(os.path.join(DATA, path)) as f:
+        return [line for line in f if line.strip()]
+
+
+# ** Lancement de P processus de front
+
+def vmhwm(pid):
+    """Pic de mémoire résidente du processus pid, en ko."""
+    try:
+        with open('/proc/%d/status' % pid) as f:
+            for line in f:
+                if line.startswith('VmHWM:'):
+                    return int(line.split()[1])
+    except OSError:
+        pass
+    return 0
+
+
+def run_case(tmp, prog, const, maps, n, param, hs, P):
+    """Retourne (temps réel, effort cumulé ou None sans -DSTATS,
+    pic RSS en ko)."""
+    mappings = read_mappings(maps)
+    procs = []
+    for w in range(P):
+        mfile = os.path.join(tmp, 'map%d' % w)
+        with open(mfile, 'w') as f:
+            f.write(mappings[w % len(mappings)])
+        args = [os.path.join(HERE, prog), str(n)]
+        if prog == 'best-parity':
+            args += ['0', str(param)]
+        else:
+            args += [str(param)]
+        args += [os.path.join(DATA, const + '.txt'), mfile]
+        if prog == 'crible':
+            hfile = os.path.join(tmp, 'h%d' % w)
+            with open(hfile, 'w') as f:
+                f.writelines(hs[w::P])
+            args.append(hfile)
+        procs.append(args)
+
+    t0 = time.monotonic()
+    running = {}
+    for args in procs:
+        p = subprocess.Popen(args, stdout=subprocess.DEVNULL,
+                             stderr=subprocess.PIPE, text=True)
+        running[p.pid] = p
+
+    # ru_maxrss compterait aussi la mémoire de ce script au
+    # moment du lancement : le pic VmHWM de chaque processus
+    # est relevé pendant qu'il tourne.
+    effort = {'parities': 0, 'codewords': 0, 'neighbours': 0}
+    rss = 0
+    done = []
+    while running:
+        for pid in running:
+            rss = max(rss, vmhwm(pid))
+        pid, status = os.waitpid(-1, os.WNOHANG)
+        if pid == 0:
+            time.sleep(0.005)
+            continue
+        p = running.pop(pid, None)
+        if p is None:
+            continue
+        if os.waitstatus_to_exitcode(status) != 0:
+            sys.exit('échec : %s' % ' '.join(p.args))
+        done.append(p)
+    wall = time.monotonic() - t0
+
+    seen = False
+    for p in done:
+        for line in p.stderr.read().splitlines():
+            if line.startswith('effort:'):
+                seen = True
+                for field in line.split()[1:]:
+                    key, value = field.split('=')
+                    effort[key] += int(value)
+    return wall, effort if seen else None, rss
+
+
+# ** Rapport
+
+FIELDS = ['program', 'constellation', 'n', 'param', 'threads', 'wall_s',
+          'parities_per_s', 'codewords_per_s', 'neighbours_per_s',
+          'peak_rss_kb', 'efficiency']
+
+
+def rate(v):
+    return '-' if v == '' else '%.4g' % v
+
+
+def table(rows):
+    heads = ['programme', 'const', 'n', 'param', 'P', 'réel (s)',
+             'parités/s', 'mots/s', 'voisins/s', 'RSS (ko)', 'eff.']
+    cells = [[r['program'], r['constellation'], str(r['n']), str(r['param']),
+              str(r['threads']), '%.3f' % r['wall_s'],
+              rate(r['parities_per_s']), rate(r['codewords_per_s']),
+              rate(r['neighbours_per_s']), str(r['peak_rss_kb']),
+              '%.2f' % r['efficiency']] for r in rows]
+    widths = [max(len(c) for c in col) for col in zip(heads, *cells)]
+    line = lambda cs: '| ' + ' | '.join(c.rjust(w) for c, w in zip(cs, widths)) + ' |'
+    rule = '|' + '+'.join('-' * (w + 2) for w in widths) + '|'
+    return '\n'.join([line(heads), rule] + [line(c) for c in cells])
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Macrobenchmarks de best-parity, spectra et crible')
+    ap.add_argument('-t', '--threads', default='1,%d' % os.cpu_count(),
+                    help='nombres de processus, séparés par des virgules')
+    ap.add_argument('-o', '--output', default='macro.csv', help='fichier CSV')
+    ap.add_argument('-r', '--repeat', type=int, default=1,
+                    help='nombre d\'essais, le meilleur est gardé')
+    ap.add_argument('filter', nargs='?', default='', help='filtre sur les cas')
+    a = ap.parse_args()
+
+    threads = sorted({int(t) for t in a.threads.split(',')})
+    rows = []
+    with tempfile.TemporaryDirectory() as tmp:
+        for prog, const, maps, n, param, hs in matrix():
+            name = '%s %s n=%d %d' % (prog, const, n, param)
+            if a.filter not in name:
+                continue
+            t1 = None
+            for P in threads:
+                best = None
+                for _ in range(a.repeat):
+                    res = run_case(tmp, prog, const, maps, n, param, hs, P)
+                    if best is None or res[0] < best[0]:
+                        best = res
+                wall, effort, rss = best
+                if t1 is None:
+                    t1 = wall * (P if prog == 'crible' else 1)
+                eff = t1 / (P * wall) if prog == 'crible' else t1 / wall
+                rows.append({
+                    'program': prog, 'constellation': const, 'n': n,
+                    'param': param, 'threads': P, 'wall_s': wall,
+                    'parities_per_s': effort['parities'] / wall if effort else '',
+                    'codewords_per_s': effort['codewords'] / wall if effort else '',
+                    'neighbours_per_s': effort['neighbours'] / wall if effort else '',
+                    'peak_rss_kb': rss, 'efficiency': eff,
+                })
+                print('%s P=%d: %.3f s' % (name, P, wall), file=sys.stderr)
+
+    with open(a.output, 'w', newline='') as f:
+        w = csv.DictWriter(f, fieldnames=FIELDS)
+        w.writeheader()
+        for r in rows:
+            w.writerow(r)
+    print(table(rows))
+
+
+if __name__ == '__main__':
+    main()
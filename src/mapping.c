@@ -0,0 +1,148 @@
+#include <limits.h>
+#include <string.h>
+
+#include "bestparity.h"
+
+
+/* * Calcul des quadrances et voisinages
+ *
+ * Les tables sont construites ligne par ligne : les
+ * quadrances de i à tous les éléments sont calculées dans
+ * une ligne de travail de q clés (quadrance, élément), dont
+ * seules les w plus petites sont triées puis gardées. La
+ * mémoire est donc en q w et non plus en q^2, et le tri en
+ * O(q log q) par ligne au lieu de O(q^2).
+ *
+ * w n'est connu qu'à la fin : chaque ligne garde le w de
+ * ses prédécesseurs, et seules les lignes passées avant que
+ * w n'atteigne sa valeur finale sont recalculées. Sur les
+ * QAM, presque tous les points intérieurs atteignent ce
+ * maximum et il n'y a qu'un passage sur les couples.
+ */
+
+
+/* Clé de tri : quadrance puis élément, pour un ordre total
+   et stable d'une construction à l'autre. */
+static inline uint64_t map_key(unsigned quad, size_t j) {
+  return (uint64_t) quad << 32 | j;
+}
+
+
+static int key_cmp(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+  return (x > y) - (x < y);
+}
+
+
+/* Range les w plus petites des len clés de K en tête de K
+   (sélection rapide de Hoare), sans les trier. */
+static void key_select(uint64_t *K, size_t len, size_t w) {
+  size_t lo = 0, hi = len;
+  while (hi - lo > 1) {
+    uint64_t pivot = K[lo + (hi - lo - 1) / 2];
+    size_t i = lo, j = hi - 1;
+    for (;;) {
+      while (K[i] < pivot) ++i;
+      while (K[j] > pivot) --j;
+      if (i >= j) break;
+      uint64_t tmp = K[i];
+      K[i++] = K[j];
+      K[j--] = tmp;
+    }
+    /* K[lo..j] <= pivot <= K[j+1..hi-1] */
+    if (w <= j) hi = j + 1;
+    else lo = j + 1;
+  }
+}
+
+
+void map_init(struct mapping *M, size_t q, const struct point *C, const size_t *pi,
+              unsigned qmax) {
+  M->q = q;
+  M->qmax = qmax;
+
+  /* P[i] est le point de la constellation donné par pi[i]
+     pour i élément de GF(q). */
+  M->P = malloc(q * sizeof *M->P);
+  for (size_t i = 0; i < q; ++i)
+    M->P[i] = C[pi[i]];
+
+  /* w est le plus grand nombre de voisins à quadrance
+     inférieure à qmax d'un élément, et qmin la plus petite
+     quadrance entre deux points distincts. R[i * cap + d]
+     garde les kept[i] plus proches clés de la ligne i. */
+  size_t w = 1, cap = 1;
+  M->qmin = UINT_MAX;
+  uint64_t *K = malloc(q * sizeof *K);
+  uint64_t *R = malloc(q * cap * sizeof *R);
+  size_t *kept = malloc(q * sizeof *kept);
+  for (size_t i = 0; i < q; ++i) {
+    size_t c = 0;
+    for (size_t j = 0; j < q; ++j) {
+      unsigned quad = map_quad(M, i, j);
+      K[j] = map_key(quad, j);
+      c += quad < qmax;
+      if (j != i && quad < M->qmin) M->qmin = quad;
+    }
+    if (c > w) w = c;
+    if (w > cap) {
+      /* Les lignes déjà rangées sont écartées, de la
+         dernière à la première */
+      size_t ncap = 2 * cap > q ? q : 2 * cap;
+      if (ncap < w) ncap = w;
+      R = realloc(R, q * ncap * sizeof *R);
+      for (size_t k = i; k-- > 1;)
+        memmove(R + k * ncap, R + k * cap, kept[k] * sizeof *R);
+      cap = ncap;
+    }
+    if (w < q) key_select(K, q, w);
+    qsort(K, w, sizeof *K, key_cmp);
+    memcpy(R + i * cap, K, w * sizeof *K);
+    kept[i] = w;
+  }
+  M->w = w;
+
+  /* V[i * w + d] retourne le d-ème élément du corps fini
+     qui est le plus proche de l'élément i selon la
+     quadrance et Q[i * w + d] cette quadrance. */
+  M->V = malloc(q * w * sizeof *M->V);
+  M->Q = malloc(q * w * sizeof *M->Q);
+  for (size_t i = 0; i < q; ++i) {
+    const uint64_t *Ki = R + i * cap;
+    if (kept[i] < w) {
+      for (size_t j = 0; j < q; ++j)
+        K[j] = map_key(map_quad(M, i, j), j);
+      if (w < q) key_select(K, q, w);
+      qsort(K, w, sizeof *K, key_cmp);
+      Ki = K;
+    }
+    for (size_t d = 0; d < w; ++d) {
+      M->V[i * w + d] = Ki[d] & 0xffffffff;
+      M->Q[i * w + d] = Ki[d] >> 32;
+    }
+  }
+  free(kept);
+  free(R);
+  free(K);
+}
+
+
+void map_print(const struct mapping *M) {
+  printf("Voisinage, qmin = %u, %zu voisins\n", M->qmin, M->w);
+  for (size_t i = 0; i < M->q; ++i) {
+    printf("  %zu:", i);
+    for (size_t d = 0; d < M->w; ++d)
+      printf("\t%u:%u", M->V[i * M->w + d], M->Q[i * M->w + d]);
+    printf("\n");
+  }
+}
+
+
+void map_free(struct mapping *M) {
+  free(M->P);
+  free(M->Q);
+  free(M->V);
+  M->P = NULL;
+  M->Q = NULL;
+  M->V = NULL;
+}
@@ -0,0 +1,338 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#include "bestparity.h"
+
+
+/* * Microbenchmarks
+ *
+ * Mesure isolée des noyaux les plus chauds sur les
+ * constellations 16-QAM, 64-QAM et 256-QAM de data/ (avec
+ * le premier mapping DVB correspondant). Chaque mesure
+ * double son nombre d'itérations jusqu'à durer au moins
+ * bench_time secondes (0,2 par défaut). Les entrées
+ * aléatoires sont tirées avec une graine fixe pour que deux
+ * exécutions travaillent sur les mêmes données.
+ *
+ * La sortie est un CSV sur la sortie standard, une ligne
+ * par noyau, variante (isa) et constellation :
+ *
+ *   kernel,isa,q,n,ops,ns_per_op,ops_per_s
+ *
+ * Une opération est un appel pour les noyaux scalaires, un
+ * symbole pour mulacc et un vecteur pour syndromes, sliced
+ * (16-QAM seulement) et quadacc. Les noyaux qui n'ont pas de variantes ont « - »
+ * pour isa.
+ */
+
+#define BENCH_N 4            /* Longueur des parités */
+#define BENCH_LEN 4096       /* Longueur des tampons de mulacc */
+#define BENCH_POOL 1024      /* Nombre d'entrées aléatoires */
+#define BENCH_SEED 0x2545f4914f6cdd1dULL
+
+static double bench_time = 0.2;
+
+
+/* ** Générateur pseudo-aléatoire (xorshift64*) */
+
+static uint64_t rnd_state;
+
+static void rnd_seed(void) {
+  rnd_state = BENCH_SEED;
+}
+
+static uint64_t rnd(void) {
+  rnd_state ^= rnd_state >> 12;
+  rnd_state ^= rnd_state << 25;
+  rnd_state ^= rnd_state >> 27;
+  return rnd_state * 0x2545f4914f6cdd1dULL;
+}
+
+
+/* ** Contexte commun aux mesures */
+
+static size_t q, n = BENCH_N;
+static struct mapping M;
+static struct evaluator E;
+static unsigned qmax;
+
+static gf_elt h[BENCH_N];
+static gf_elt X[BENCH_POOL * BENCH_N];   /* Vecteurs aléatoires */
+static int L[BENCH_POOL];                /* Logarithmes aléatoires */
+static uint8_t A[BENCH_LEN], B[BENCH_LEN];
+static struct gf_mul hm[BENCH_N];
+static uint8_t Y[BENCH_N * KERN_BLOCK], s[KERN_BLOCK];
+static uint16_t Eb[KERN_BLOCK];
+static unsigned qb[KERN_BLOCK];
+static unsigned long *S1, *S2;
+
+/* Empêche le compilateur d'éliminer les calculs */
+static volatile unsigned long sink;
+
+
+/* ** Les mesures
+ *
+ * Chaque fonction exécute iters fois le noyau.
+ */
+
+static void b_accmul(size_t iters) {
+  gf_elt acc = gf_zero;
+  for (size_t k = 0; k < iters; ++k)
+    gf_accmul(&acc, L[k % BENCH_POOL], X[k % BENCH_POOL]);
+  sink = acc;
+}
+
+static void b_mulacc(size_t iters) {
+  for (size_t k = 0; k < iters; ++k)
+    kern->mulacc(A, hm + k % BENCH_N, B, BENCH_LEN);
+  sink = A[0];
+}
+
+static void b_syndromes(size_t iters) {
+  for (size_t k = 0; k < iters; ++k)
+    kern->syndromes(n, hm, Y, KERN_BLOCK, KERN_BLOCK, s);
+  sink = s[0];
+}
+
+static void b_sliced(size_t iters) {
+  uint64_t acc = 0;
+  for (size_t k = 0; k < iters; ++k)
+    acc ^= kern->sliced(n, hm, Y, KERN_BLOCK, KERN_BLOCK);
+  sink = acc;
+}
+
+static void b_quadacc(size_t iters) {
+  for (size_t k = 0; k < iters; ++k)
+    kern->quadacc(qb, Y, E.T, Eb, KERN_BLOCK);
+  sink = qb[0];
+}
+
+static void b_spcmp(size_t iters) {
+  int r = 0;
+  for (size_t k = 0; k < iters; ++k) {
+    S1[qmax - 1] = k & 1;
+    r += sp_cmp(S1, S2, qmax);
+  }
+  sink = r;
+}
+
+static void b_chk_valid(size_t iters) {
+  unsigned long c = 0;
+  for (size_t k = 0; k < iters; ++k)
+    c += chk_valid(n, h, X + k % BENCH_POOL * n);
+  sink = c;
+}
+
+static void b_cw_next(size_t iters) {
+  gf_elt x[BENCH_N];
+  cw_begin(n, h, x);
+  for (size_t k = 0; k < iters; ++k)
+    if (!cw_next(n, h, x))
+      cw_begin(n, h, x);
+  sink = x[n-1];
+}
+
+static void b_chk_next(size_t iters) {
+  gf_elt g[BENCH_N];
+  chk_begin(n, g);
+  for (size_t k = 0; k < iters; ++k)
+    if (!chk_next(n, g))
+      chk_begin(n, g);
+  sink = g[0];
+}
+
+static void b_banker(size_t iters) {
+  const int length = 16;
+  unsigned long b = 0;
+  for (size_t k = 0; k < iters; ++k)
+    if ((b = banker(b, length)) == (1UL << length) - 1)
+      b = 0;
+  sink = b;
+}
+
+/* Compositions de quad = 4 qmin sur n cases en quadrances
+   présentes dans la constellation, comme crible */
+static void b_compnext(size_t iters) {
+  const int quad = 4 * M.qmin;
+  unsigned long ok[4 * M.qmin + 1];
+  memset(ok, 0, sizeof ok);
+  for (size_t i = 0; i < q * M.w; ++i)
+    if (M.Q[i] <= (unsigned) quad) ok[M.Q[i]] = 1;
+
+  int p[BENCH_N];
+  p[0] = -1;
+  for (size_t k = 0; k < iters; ++k)
+    if (!compnext(n, p, quad, ok))
+      p[0] = -1;
+  sink = p[0];
+}
+
+static void b_permnext(size_t iters) {
+  int p[BENCH_N];
+  for (size_t i = 0; i < n; ++i) p[i] = i;
+  for (size_t k = 0; k < iters; ++k)
+    if (!permnext(n, p))
+      for (size_t i = 0; i < n; ++i) p[i] = i;
+  sink = p[0];
+}
+
+/* Pas du parcours des voisins de best-parity, sur tous les
+   poids dw tour à tour */
+static void b_nb_next(size_t iters) {
+  size_t dw = 2;
+  const size_t *dm = E.dcap + dw * q;
+  nb_begin(&E, dw);
+  for (size_t k = 0; k < iters; ++k)
+    if (!nb_next(&E, dw, dm, E.x)) {
+      dw = dw == n ? 2 : dw + 1;
+      dm = E.dcap + dw * q;
+      nb_begin(&E, dw);
+    }
+  sink = E.da[0];
+}
+
+
+/* ** Chronométrage */
+
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+
+/* Mesure f et affiche une ligne CSV. ops est le nombre
+   d'opérations par itération. */
+static void run(const char *name, const char *isa, size_t ops, void (*f)(size_t)) {
+  size_t iters = 1;
+  double dt;
+
+  for (;;) {
+    double t0 = now();
+    f(iters);
+    dt = now() - t0;
+    if (dt >= bench_time) break;
+    iters *= 2;
+  }
+
+  double total = (double) iters * ops;
+  printf("%s,%s,%zu,%zu,%.0f,%.3f,%.4g\n",
+         name, isa, q, n, total, 1e9 * dt / total, total / dt);
+  fflush(stdout);
+}
+
+
+/* ** Préparation d'une constellation */
+
+static void setup(const char *dir, size_t Q) {
+  char constfile[256], mapsfile[256];
+  snprintf(constfile, sizeof constfile, "%s/%zu-QAM.txt", dir, Q);
+  snprintf(mapsfile, sizeof mapsfile, "%s/%zu-DVB.txt", dir, Q);
+
+  struct point *C;
+  size_t m;
+  q = const_read(constfile, &C, &m);
+
+  FILE *f;
+  if (NULL == (f = fopen(mapsfile, "r")))
+    error("Impossible d'ouvrir le fichier mapping '%s'.", mapsfile);
+  size_t *pi = malloc(q * sizeof *pi);
+  if (!map_read(f, q, pi))
+    error("Fichier mapping incomplet\n");
+  fclose(f);
+
+  gf_init(primitives[m]);
+  map_init(&M, q, C, pi, UINT_MAX);
+  free(C);
+  free(pi);
+
+  qmax = 4 * M.qmin;
+  ev_init(&E, &M, n, qmax);
+
+  /* Entrées aléatoires */
+  rnd_seed();
+  for (size_t i = 0; i < n; ++i)
+    h[i] = rnd() % gf_size_minus_1;
+  h[n-1] = 0;
+  for (size_t k = 0; k < BENCH_POOL * n; ++k) X[k] = rnd() % q;
+  for (size_t k = 0; k < BENCH_POOL; ++k) L[k] = rnd() % gf_size_minus_1;
+  for (size_t k = 0; k < BENCH_LEN; ++k) A[k] = rnd() % q;
+  for (size_t k = 0; k < BENCH_LEN; ++k) B[k] = rnd() % q;
+  for (size_t k = 0; k < n * KERN_BLOCK; ++k) Y[k] = rnd() % q;
+  for (size_t k = 0; k < KERN_BLOCK; ++k) Eb[k] = rnd() % (q * M.w);
+  for (size_t i = 0; i < n; ++i)
+    gf_mul_init(hm + i, h[i]);
+
+  /* Un mot de code pour le parcours des voisins */
+  cw_begin(n, h, E.x);
+  for (size_t k = rnd() % 1000; k > 0; --k)
+    cw_next(n, h, E.x);
+
+  /* Deux spectres égaux : la comparaison va jusqu'au bout */
+  S1 = malloc(qmax * sizeof *S1);
+  S2 = malloc(qmax * sizeof *S2);
+  for (size_t i = 0; i < qmax; ++i)
+    S1[i] = S2[i] = rnd() % 1000;
+}
+
+
+static void teardown(void) {
+  free(S1);
+  free(S2);
+  ev_free(&E);
+  map_free(&M);
+  gf_free();
+}
+
+
+int main(int argc, char **argv) {
+  const char *dir = "../data";
+
+  if (argc > 3) {
+    printf("Usage: %s [datadir [seconds]]\n", argv[0]);
+    return -1;
+  }
+  if (argc > 1) dir = argv[1];
+  if (argc > 2 && 1 != sscanf(argv[2], "%lf", &bench_time))
+    error("La durée doit être un nombre: '%s'", argv[2]);
+
+  const char *isas[KERN_VARIANTS];
+  size_t nisa = kern_list(isas);
+
+  printf("kernel,isa,q,n,ops,ns_per_op,ops_per_s\n");
+
+  const size_t sizes[] = {16, 64, 256};
+  for (size_t t = 0; t < sizeof sizes / sizeof *sizes; ++t) {
+    setup(dir, sizes[t]);
+
+    run("gf_accmul", "-", 1, b_accmul);
+    for (size_t i = 0; i < nisa; ++i) {
+      kern_init(isas[i]);
+      for (size_t j = 0; j < n; ++j)
+        gf_mul_init(hm + j, h[j]);
+      run("mulacc", isas[i], BENCH_LEN, b_mulacc);
+      run("syndromes", isas[i], KERN_BLOCK, b_syndromes);
+      if (gf_degree <= 4)
+        run("sliced", isas[i], KERN_BLOCK, b_sliced);
+      run("quadacc", isas[i], KERN_BLOCK, b_quadacc);
+      run("sp_cmp", isas[i], 1, b_spcmp);
+    }
+    kern_init(getenv("BESTPARITY_ISA"));
+
+    run("chk_valid", "-", 1, b_chk_valid);
+    run("cw_next", "-", 1, b_cw_next);
+    run("chk_next", "-", 1, b_chk_next);
+    run("banker", "-", 1, b_banker);
+    run("compnext", "-", 1, b_compnext);
+    run("permnext", "-", 1, b_permnext);
+    run("nb_next", "-", 1, b_nb_next);
+
+    teardown();
+  }
+
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bestparity.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+
+/* * Compteurs matériels
+ *
+ * Un groupe d'événements perf (le premier qui réussit en
+ * est le chef, les autres s'y joignent s'ils sont
+ * disponibles) est ouvert au premier pf_switch.
+ * Les compteurs ne sont jamais arrêtés : un changement de
+ * phase lit le groupe d'un coup et attribue la différence à
+ * la phase qui se termine. Seul le code utilisateur est
+ * compté, ce qui suffit avec perf_event_paranoid <= 2.
+ */
+
+static const char *pf_phase_names[PF_PHASES] = {
+  [PF_TABLES] = "tables",
+  [PF_SEARCH] = "recherche",
+  [PF_OUTPUT] = "sorties",
+};
+
+static const char *pf_event_names[PF_EVENTS] = {
+  [PF_CYCLES]       = "cycles",
+  [PF_INSTRUCTIONS] = "instructions",
+  [PF_L1D_MISSES]   = "L1d-misses",
+  [PF_LLC_MISSES]   = "LLC-misses",
+  [PF_BRANCH_MISSES]= "branch-misses",
+};
+
+bool pf_enabled;
+
+static struct {
+  bool opened;
+  int leader;                        /* -1 si rien n'a pu être ouvert */
+  int slot[PF_EVENTS];               /* Rang dans le groupe ou -1 */
+  size_t nslots;
+  int phase;
+  uint64_t last[PF_EVENTS];
+  uint64_t acc[PF_PHASES][PF_EVENTS];
+} pf;
+
+
+void pf_start(void) {
+  const char *env = getenv("BESTPARITY_PERF");
+  pf_enabled = env != NULL && *env != '\0' && strcmp(env, "0") != 0;
+#ifndef __linux__
+  if (pf_enabled)
+    fprintf(stderr, "perf: compteurs matériels indisponibles sur ce système\n");
+  pf_enabled = false;
+#endif
+}
+
+
+#ifdef __linux__
+
+static int pf_open(int event, int group) {
+  static const struct { uint32_t type; uint64_t config; } ev[PF_EVENTS] = {
+    [PF_CYCLES]       = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    [PF_INSTRUCTIONS] = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    [PF_L1D_MISSES]   = {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                         | PERF_COUNT_HW_CACHE_OP_READ << 8
+                         | PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+    [PF_LLC_MISSES]   = {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    [PF_BRANCH_MISSES]= {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  };
+
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof attr);
+  attr.size = sizeof attr;
+  attr.type = ev[event].type;
+  attr.config = ev[event].config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+
+/* Ouvre le groupe. En cas d'échec complet, le prévient
+   une fois et coupe tout. */
+static void pf_open_group(void) {
+  pf.opened = true;
+  pf.leader = -1;
+  pf.nslots = 0;
+  int err = 0;
+  for (int k = 0; k < PF_EVENTS; ++k) {
+    int fd = pf_open(k, pf.leader);
+    if (fd < 0) {
+      pf.slot[k] = -1;
+      err = errno;
+      continue;
+    }
+    if (pf.leader < 0) pf.leader = fd;
+    pf.slot[k] = pf.nslots++;
+  }
+
+  if (pf.leader < 0) {
+    fprintf(stderr, "perf: compteurs matériels indisponibles (%s)\n", strerror(err));
+    pf_enabled = false;
+  }
+}
+
+
+static void pf_read(uint64_t *v) {
+  uint64_t buf[1 + PF_EVENTS];
+  if (read(pf.leader, buf, sizeof buf) < (ssize_t) sizeof *buf)
+    return;
+  for (int k = 0; k < PF_EVENTS; ++k)
+    if (pf.slot[k] >= 0)
+      v[k] = buf[1 + pf.slot[k]];
+}
+
+
+void pf_switch(int phase) {
+  if (!pf.opened) {
+    pf_open_group();
+    if (!pf_enabled) return;
+    pf_read(pf.last);
+    pf.phase = phase;
+    return;
+  }
+  if (pf.leader < 0) return;
+
+  uint64_t now[PF_EVENTS] = {0};
+  pf_read(now);
+  for (int k = 0; k < PF_EVENTS; ++k) {
+    pf.acc[pf.phase][k] += now[k] - pf.last[k];
+    pf.last[k] = now[k];
+  }
+  pf.phase = phase;
+}
+
+#else
+
+void pf_switch(int phase) { (void) phase; }
+
+#endif
+
+
+void pf_report(FILE *f) {
+  if (!pf_enabled || !pf.opened) return;
+  /* Clôt la phase en cours */
+  pf_switch(pf.phase);
+  bool pf_seen[PF_EVENTS];
+  for (int k = 0; k < PF_EVENTS; ++k) pf_seen[k] = pf.slot[k] >= 0;
+
+  fprintf(f, "Compteurs matériels\n  %-14s", "phase");
+  for (int k = 0; k < PF_EVENTS; ++k)
+    if (pf_seen[k]) fprintf(f, " %15s", pf_event_names[k]);
+  if (pf_seen[PF_CYCLES] && pf_seen[PF_INSTRUCTIONS]) fprintf(f, " %6s", "IPC");
+  fprintf(f, "\n");
+
+  for (int p = 0; p < PF_PHASES; ++p) {
+    fprintf(f, "  %-14s", pf_phase_names[p]);
+    for (int k = 0; k < PF_EVENTS; ++k)
+      if (pf_seen[k]) fprintf(f, " %15llu", (unsigned long long) pf.acc[p][k]);
+    if (pf_seen[PF_CYCLES] && pf_seen[PF_INSTRUCTIONS])
+      fprintf(f, " %6.2f", pf.acc[p][PF_CYCLES] == 0 ? 0.0
+              : (double) pf.acc[p][PF_INSTRUCTIONS] / pf.acc[p][PF_CYCLES]);
+    fprintf(f, "\n");
+  }
+}
@@ -0,0 +1,108 @@
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "bestparity.h"
+
+
+/* * Progression
+ *
+ * Rien n'est fait sans BESTPARITY_PROGRESS. Sinon, un
+ * minuteur (SIGALRM) et SIGUSR1 ne font que lever
+ * pg_due ; la ligne est écrite par pg_tick, depuis la
+ * boucle principale, au passage suivant. Le débit est une
+ * moyenne glissante sur les dernières périodes : le coût
+ * des parités n'est pas uniforme (coupures, cappage), et un
+ * débit moyen depuis le départ donnerait une ETA fausse.
+ */
+
+volatile sig_atomic_t pg_due;
+unsigned long long pg_parities, pg_cut;
+
+static struct {
+  const char *what;            /* Unité de progression */
+  unsigned long long total;    /* 0 si inconnu */
+  double t0, tlast;            /* Départ et dernier affichage */
+  unsigned long long dlast;    /* Avancement au dernier affichage */
+  double rate;                 /* Débit lissé */
+} pg;
+
+
+static double pg_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+
+static void pg_signal(int sig) {
+  (void) sig;
+  pg_due = 1;
+}
+
+
+void pg_start(const char *what, unsigned long long total) {
+  pg.what = what;
+  pg.total = total;
+  pg.t0 = pg.tlast = pg_now();
+  pg.dlast = 0;
+  pg.rate = 0;
+
+  /* Période en secondes, 0 pour n'écrire que sur SIGUSR1 */
+  const char *env = getenv("BESTPARITY_PROGRESS");
+  if (env == NULL || *env == '\0') return;
+  double period = atof(env);
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof sa);
+  sa.sa_handler = pg_signal;
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGUSR1, &sa, NULL);
+
+  if (period > 0) {
+    sigaction(SIGALRM, &sa, NULL);
+    struct itimerval it;
+    it.it_interval.tv_sec = (time_t) period;
+    it.it_interval.tv_usec = (period - (time_t) period) * 1e6;
+    it.it_value = it.it_interval;
+    setitimer(ITIMER_REAL, &it, NULL);
+  }
+}
+
+
+void pg_print(unsigned long long done) {
+  pg_due = 0;
+
+  double t = pg_now();
+  if (t > pg.tlast && done >= pg.dlast) {
+    double r = (done - pg.dlast) / (t - pg.tlast);
+    pg.rate = pg.rate == 0 ? r : 0.3 * r + 0.7 * pg.rate;
+    pg.tlast = t;
+    pg.dlast = done;
+  }
+
+  /* Champs toujours présents et dans cet ordre, « - » pour
+     une valeur inconnue, cf. bestparity.h */
+  fprintf(stderr, "progress: unit=%s done=%llu", pg.what, done);
+  if (pg.total > 0) fprintf(stderr, " total=%llu", pg.total);
+  else fprintf(stderr, " total=-");
+  fprintf(stderr, " elapsed=%.1f rate=%.4g", t - pg.t0, pg.rate);
+  if (pg_parities > 0)
+    fprintf(stderr, " cut=%.4f", (double) pg_cut / pg_parities);
+  else
+    fprintf(stderr, " cut=-");
+  if (pg.total > 0 && pg.rate > 0)
+    fprintf(stderr, " eta=%.0f\n", (pg.total - done) / pg.rate);
+  else
+    fprintf(stderr, " eta=-\n");
+  fflush(stderr);
+}
+
+
+void pg_stop(void) {
+  struct itimerval it;
+  memset(&it, 0, sizeof it);
+  setitimer(ITIMER_REAL, &it, NULL);
+  signal(SIGALRM, SIG_IGN);
+}
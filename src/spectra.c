@@ -3,162 +3,24 @@
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
+#include <unistd.h>
 
-#define error(format, ...)                                                 \
-  do {                                                                     \
-    fflush (stdout);                                                       \
-    fprintf (stderr, "%s:%d: " format, __FILE__, __LINE__, ##__VA_ARGS__); \
-    fprintf (stderr, "\n");                                                \
-    exit (EXIT_FAILURE);                                                   \
-  } while (0)
+#include "bestparity.h"
 
 
 
-/* * Bibliothèque GF(2^m)
- *
- * Bibliothèque pour les corps finis GF(q) avec q=2^m. Les
- * éléments du corps sont représentés par des entiers de
- * 0 à q-1.
- *
- * Comme la caractéristique est 2, l'addition est le ou
- * exclusif.
- *
- * Pour la multiplication, on utilise une table de
- * logarithme sur la base d'un élément primitif. Seule cette
- * table est nécessaire pour construire le corps complet.
- *
- * Pour éviter de se trimbaler sans cesse la représentation
- * du corps, on fait appel à des variables globales. Il
- * n'est donc possible de travailler qu'avec un corps à la
- * fois.
- *
- * La construction d'un corps fini repose sur un polynôme
- * primitif. Voici une liste pour GF(2^m) pour les premières
- * valeurs de m.
- */
-
-
-/* Liste de polynômes primitifs pour construire GF(2^m) pour
-   m allant de 1 à 10.
-
-   |    q | P                         | P binaire     | P hexdécimal |
-   |------+---------------------------+---------------+--------------|
-   |    2 | X + 1                     | 11            |          0x3 |
-   |    4 | X^2 + X + 1               | 111           |          0x7 |
-   |    8 | X^3 + X + 1               | 1011          |          0xb |
-   |   16 | X^4 + X + 1               | 1 0011        |         0x13 |
-   |   32 | X^5 + X^2 + 1             | 10 0101       |         0x25 |
-   |   64 | X^6 + X + 1               | 100 0011      |         0x43 |
-   |  128 | X^7 + X^3 + 1             | 1000 1001     |         0x89 |
-   |  256 | X^8 + X^4 + X^3 + X^2 + 1 | 1 0001 1101   |        0x11d |
-   |  512 | X^9 + X^5 + 1             | 10 0010 0001  |        0x221 |
-   | 1024 | X^10 + X^3 + 1            | 100 0000 1001 |        0x409 |
- */
-const size_t n_primitives = 10;
-const unsigned primitives[] = {0x1, 0x3, 0x7, 0xb, 0x13, 0x25,
-                               0x43, 0x89, 0x11d, 0x221, 0x409};
-
-
-/* ** Types */
-
-/* Un élément de GF(q) est représenté par un entier non
-   signé entre 0 et q-1.*/
-typedef unsigned int gf_elt;
-
-
-/* ** Constantes */
-
-/* Quelques constantes sur le corps fini. */
-size_t gf_size;                 // Taille du corps
-size_t gf_size_minus_1;         // Taille du corps
-size_t gf_degree;               // Degré: 2^deg = size
-const gf_elt gf_zero = 0;       // Le zéro
-const gf_elt gf_one = 1;        // Le un
-gf_elt gf_alpha;                // Un élément primitif
-
-
-/* La table des logarithmes: un élément non nul $x$ de GF(q)
-   s'écrit comme une puissance $\alpha^k$ d'un élément
-   primitif $\alpha$. Cette table indicée par $x$ retourne
-   la puissance $k$ correspondante. Pour 0, elle
-   retourne -1. La table gf_exp fait l'inverse, elle
-   retourne $\alpha^k$ à partir de l'indice $k$. */
-int *gf_log;
-gf_elt *gf_exp;
-
-
-/* ** Opérations algébriques */
-
-
-/* Calcul acc <- acc + \alpha^hlog * x. hlog doit être entre
-   0 et gf_size_minus_1 exclu. */
-static inline void gf_accmul(gf_elt *acc, int hlog, gf_elt x) {
-  if (x == gf_zero) return;
-  *acc ^= gf_exp[(hlog + gf_log[x]) % gf_size_minus_1]; 
-}
-
+/* * Vecteurs et incréments */
 
-/* ** Initialisation et libération */ 
-
-/* Initialisation du corps fini GF(q) à partir d'un polynôme
-   primitif P qui est donné par sa représentation binaire.
-   Ainsi, pour GF(8), le polynôme P = X^3 + X + 1 se
-   représente par l'entier 11 en décimal c'est-à-dire 1011
-   en binaire.
-*/
-static int gf_init(unsigned P) {
-  // Lecture de la taille en lisant le degré de P
-  gf_degree = 0;
-  for (unsigned p = P; p > 0; p >>= 1) gf_degree++;
-  gf_size = 1 << --gf_degree;
-  gf_size_minus_1 = gf_size - 1;
-  
-  // Construction des tables de log et de puissances
-  gf_log = malloc(gf_size * sizeof *gf_log);
-  gf_exp = malloc(gf_size * sizeof *gf_exp); // Normalement gf_size_minus_1....
-  gf_log[gf_zero] = -1; // 0 n'est pas une puissance de alpha !
-
-  gf_elt x = gf_one;
-  for (size_t k = 0; k < gf_size_minus_1; k++) {
-    gf_log[x] = k;              // remplissage des tables
-    gf_exp[k] = x;
-    x <<= 1;                    // puissance suivante
-    if (x >= gf_size)
-      x ^= P;
-  }
-  gf_alpha = gf_exp[1];         // élément primitif
-
-  if (x != gf_one)             // Soucis, alpha pas primitif
-    error("gf_init: Corps fini incorrect: polynôme non primitif\n");
-
-  return 0;
-}
-
-
-/* Libération des ressources utilisées par le corps */
-static int gf_free() {
-  free(gf_log);
-  free(gf_exp);
-  gf_log = NULL;
-  gf_exp = NULL;
-  return 0;
-}
-
-
-/* * Mots de code et parités */
-
-/* Initialise un itérateur dans x sur les mots de codes de
-   la parité h. */
-static inline void cw_begin(size_t n, gf_elt *x) {
+/* Initialise un itérateur dans x sur tous les vecteurs de
+   GF(q)^n. */
+static inline void vec_begin(size_t n, gf_elt *x) {
   memset(x, 0, n * sizeof *x);
 }
 
 
-/* Passe au mot de code suivant x de la parité h et retourne
-   false si plus aucun mot de code n'est obtenable. On
-   utilise le fait ici que le dernier coefficient de h est
-   1. */
-static inline bool cw_next(size_t n, gf_elt *x) {
+/* Passe au vecteur suivant x et retourne false si tous ont
+   été visités. */
+static inline bool vec_next(size_t n, gf_elt *x) {
   size_t i = 0;
   for (i = 0; i < n; ++i)
     if (x[i] == gf_size_minus_1)
@@ -171,55 +33,84 @@ static inline bool cw_next(size_t n, gf_elt *x) {
 }
 
 
-/* Initialise un itérateur dans delta sur les incréments
-   delta pour obtenir les voisins à partir de x. */
-static inline void delta_begin(size_t n, size_t *d) {
-  memset(d, 0, n * sizeof *d);
-}
-
-
-/* Passe à l'incrément suivant. */
-static inline bool delta_next(size_t n, size_t *dmax, size_t *d) {
-  /* passage au suivant sans coupure */
-  size_t i = 0;
-  for (i = 0; i < n; ++i)
-    if (d[i] >= dmax[i]-1)
-      d[i] = 0;
-    else
-      break;
-  if (i == n) return false;
-  d[i]++;
-  return true;
-}
-
-
+/* ** Voisins
+ *
+ * Parcours en profondeur des incréments d, d[0] le plus
+ * rapide, où y[i] = V[x[i] * w + d[i]] est le d[i]-ème
+ * symbole le plus proche de x[i]. acc[i] est la quadrance
+ * partielle des positions i..n-1 et nz[i] leur nombre de
+ * positions modifiées (acc[n] = nz[n] = 0).
+ *
+ * Un voisin y != x ne peut donner un couple de mots de code
+ * que s'il diffère de x en deux positions au moins : la
+ * quadrance restante est donc au moins qmin tant qu'une
+ * seule position est modifiée, 0 ensuite. Les lignes de V
+ * étant triées par quadrance croissante, le premier
+ * incrément qui dépasse qmax avec ce minimum coupe tous les
+ * suivants à sa position, et le parcours remonte à la
+ * position suivante. Seuls x et les voisins à quadrance
+ * inférieure à qmax qui diffèrent de x en deux positions
+ * au moins sont produits.
+ */
 
-/* Indique si une parité h de longueur n est vérifiée par le
-   vecteur x. */
-static inline bool chk_valid(size_t n, gf_elt *h, gf_elt *x) {
-  gf_elt acc = gf_zero;
-  for (size_t i = 0; i < n-1; ++i)
-    gf_accmul(&acc, *h++, *x++);
-  return acc == *x;
+struct delta {
+  const struct mapping *M;
+  size_t n;
+  unsigned qmax;
+  const gf_elt *x;
+  size_t *d;
+  gf_elt *y;
+  unsigned *acc, *nz;
+};
+
+
+/* Premier voisin : y = x. */
+static inline void delta_begin(struct delta *D, const gf_elt *x) {
+  D->x = x;
+  memset(D->d, 0, D->n * sizeof *D->d);
+  memcpy(D->y, x, D->n * sizeof *D->y);
+  memset(D->acc, 0, (D->n + 1) * sizeof *D->acc);
+  memset(D->nz, 0, (D->n + 1) * sizeof *D->nz);
 }
 
 
-/* Initialise un itérateur sur les parités remplissant h. */
-static inline void chk_begin(size_t n, gf_elt *h) {
-  for (size_t i = 0; i < n-1; ++i)
-    h[i] = n-i-1;
-  h[n-1] = 0;
+/* Passe au sommet suivant de l'arbre et retourne false s'il
+   n'y en a plus. */
+static inline bool delta_step(struct delta *D) {
+  const size_t n = D->n, w = D->M->w;
+  const unsigned *Q = D->M->Q;
+  const gf_elt *V = D->M->V;
+  for (size_t i = 0; i < n; ++i) {
+    gf_elt xi = D->x[i];
+    if (D->d[i] + 1 == w) continue;
+    gf_elt yi = V[xi * w + D->d[i] + 1];
+    unsigned a = D->acc[i+1] + Q[xi * w + D->d[i] + 1];
+    unsigned k = D->nz[i+1] + 1;
+    if (k >= 2 ? a >= D->qmax : i == 0 || a + D->M->qmin >= D->qmax)
+      continue;                 /* Coupure */
+
+    D->d[i]++;
+    D->y[i] = yi;
+    D->acc[i] = a;
+    D->nz[i] = k;
+    for (size_t j = 0; j < i; ++j) {
+      D->d[j] = 0;
+      D->y[j] = D->x[j];
+      D->acc[j] = a;
+      D->nz[j] = k;
+    }
+    return true;
+  }
+  return false;
 }
 
 
-/* Passe à la parité suivante */
-static inline bool chk_next(size_t n, gf_elt *h) {
-  size_t i;
-  for (i = 0; h[i] >= gf_size_minus_1 - i - 1; ++i)
-    if (i + 3 > n)
-      return false;
-  for (h[i]++; i; i--)
-    h[i-1] = h[i] + 1;
+/* Passe au voisin suivant de x, les sommets où une seule
+   position est modifiée n'en étant pas. */
+static inline bool delta_next(struct delta *D) {
+  do {
+    if (!delta_step(D)) return false;
+  } while (D->nz[0] == 1);
   return true;
 }
 
@@ -231,15 +122,69 @@ static inline bool chk_next(size_t n, gf_elt *h) {
  * spectre de distance pour une constellation et un mapping
  * donnés. L'algorithme général est le suivant
  *
- * Pour chaque couple de vecteur (x, y)
- *   Si quadrance (x, y) > qmax
- *     Passer au couple x,y suivant
+ * Pour chaque couple de vecteur (x, y) de quadrance
+ * inférieure à qmax (cf. delta_next)
  *   Pour chaque parité h telle que hx = hy = 0
  *     Incrémenter le spectre de h pour quadrance(x, y)
  * Afficher les parités et leur spectre
  *
+ * La table des spectres a une ligne de qmax compteurs par
+ * parité. Si elle dépasse le budget mémoire donné par
+ * BESTPARITY_MEMORY (en octets, suffixes k, M et G admis),
+ * les parités sont traitées par blocs consécutifs dans
+ * l'ordre de chk_next : un passage sur les couples (x, y)
+ * par bloc, dont les spectres sont affichés dès qu'il est
+ * terminé. Sans BESTPARITY_MEMORY, le budget est la moitié
+ * de la mémoire physique : sous Linux, une allocation trop
+ * grande réussit quand même et le processus n'est tué
+ * qu'en touchant la table.
+ *
+ * Les compteurs sont sur 32 bits ; celui qui revient à zéro
+ * est promu : ses bits de poids fort sont tenus à part dans
+ * la liste des débordements du bloc, qui reste courte.
+ *
+ * Les spectres sont affichés en entier (une colonne par
+ * quadrance), en lignes creuses avec BESTPARITY_SPARSE=1
+ * (couples quadrance:multiplicité non nulle), ou, si un
+ * fichier est donné en dernier argument, écrits dans ce
+ * fichier au format binaire compressé de spio.c, que relit
+ * spread.
  */
 
+/* Bits de poids fort d'un compteur promu */
+struct overflow {
+  size_t index;              /* Dans S */
+  unsigned long long high;
+};
+
+static int overflow_cmp(const void *a, const void *b) {
+  const struct overflow *x = a, *y = b;
+  return (x->index > y->index) - (x->index < y->index);
+}
+
+
+/* Budget mémoire en octets : BESTPARITY_MEMORY, ou la
+   moitié de la mémoire physique. */
+static size_t mem_budget(void) {
+  const char *env = getenv("BESTPARITY_MEMORY");
+  if (env == NULL || *env == '\0') {
+    long pages = sysconf(_SC_PHYS_PAGES), size = sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || size <= 0)
+      error("Mémoire physique inconnue, fixer BESTPARITY_MEMORY.");
+    return (size_t) pages * size / 2;
+  }
+  char *end;
+  unsigned long long b = strtoull(env, &end, 10);
+  switch (*end) {
+  case 'G': case 'g': b <<= 10; /* fallthrough */
+  case 'M': case 'm': b <<= 10; /* fallthrough */
+  case 'k': case 'K': b <<= 10; ++end; break;
+  }
+  if (end == env || *end != '\0' || b == 0)
+    error("BESTPARITY_MEMORY doit être une taille en octets: '%s'", env);
+  return b;
+}
+
 int main(int argc, char **argv) {
   /* Paramètres */
   size_t m;            /* GF(2^m) */
@@ -254,30 +199,23 @@ int main(int argc, char **argv) {
 
   
   /* ** Lecture des arguments */
-  if (argc == 5) {       /* Mode ligne de commande */
+  const char *binfile = NULL; /* Fichier des spectres compressés */
+  if (argc == 5 || argc == 6) {       /* Mode ligne de commande */
     if (1 != sscanf(argv[1], "%zu", &n)) error("L'option codelength doit être entier: '%s'", argv[1]);
     if (1 != sscanf(argv[2], "%u", &qmax)) error("L'option qmax doit être entier: '%s'", argv[3]);
     strncpy(constfile, argv[3], 80);
     strncpy(mapsfile, argv[4], 80);
+    if (argc == 6) binfile = argv[5];
   } else {                      /* Mode aide */
-    printf("Usage: %s codelength qmax constellation mappings\n", argv[0]);
+    printf("Usage: %s codelength qmax constellation mappings [spectra.bin]\n", argv[0]);
     return -1;
   }
 
   
   /* ** Lecture de la constellation sur constfile et
      ** récupération de sa taille. */
-  if (NULL == (f = fopen(constfile, "r")))
-    error("Impossible d'ouvrir le fichier constellation '%s'.", constfile);
-  q = 0;
-  m = 0;
-  struct { int x, y; } *C = malloc((1 << m) * sizeof *C);
-  while (2 == fscanf(f, "%u%u", &C[q].x, &C[q].y))
-    if (++q == (1 << m))
-      if (NULL == (C = realloc(C, (1 << ++m) * sizeof *C)))
-        error("Allocation mémoire impossible.");
-  m--;
-  fclose(f);    
+  struct point *C;
+  q = const_read(constfile, &C, &m);
 
   printf("Constellation: %s\n", constfile);
 #ifdef DEBUG
@@ -287,28 +225,30 @@ int main(int argc, char **argv) {
 
   
   /* ** Construction du corps fini */
-  if (1 << m != q) error("Corps de caractéristique 2 uniquement.");
   if (n >= q) error("codelength doit être inférieur à l'ordre du corps.");
   
+  pf_start();
+  tr_start(argv[0]);
+  pf_phase(PF_TABLES);
+  uint64_t t0 = tr_begin();
   gf_init(primitives[m]);
-  printf("GF(%zu = 2^%zu)\n", q, m);
+  tr_end(TR_TABLES, t0, -1, -1);
+  printf("GF(%zu = 2^%zu) [%s]\n", q, m, kern->name);
   printf("codelength: %zu\n", n);
   printf("qmax: %u\n", qmax); 
 
   
   /* ** Lecture du mapping */
   size_t *pi = malloc(q * sizeof *pi); // Le mapping
+  t0 = tr_begin();
   
   if (strcmp (mapsfile, "-") == 0)
     f = stdin;
   else if (NULL == (f = fopen(mapsfile, "r")))
     error("Impossible d'ouvrir le fichier mapping '%s'.", mapsfile); 
 
-  for (size_t i = 0; i < q; ++i)
-    if (1 != fscanf(f, "%zu", pi + i))
-      error("Fichier mapping incomplet\n");
-    else if (pi[i] >= q)
-      error("Valeur de mapping hors bornes\n");
+  if (!map_read(f, q, pi))
+    error("Fichier mapping incomplet\n");
 
   printf("Mapping:");
   for (size_t i = 0; i < q; ++i)
@@ -318,166 +258,188 @@ int main(int argc, char **argv) {
 
   /* ** Calcul des quadrances et voisinages */
   
-  /* Q[i*q + j] retourne la quadrance (distance au carré)
-     entre les points de la constellation donnés par pi[i]
-     et pi[j] pour i et j éléments de GF(q). */
-  unsigned *Q = malloc(q * q * sizeof *Q);
-  for (gf_elt i = 0; i < q; ++i)
-    for (gf_elt j = 0; j < q; ++j) {
-      unsigned dx = C[pi[i]].x - C[pi[j]].x;
-      unsigned dy = C[pi[i]].y - C[pi[j]].y;
-      Q[i * q + j] = dx * dx + dy * dy;
-    }
-
-#ifdef DEBUG
-  printf("Quadrances\n");
-  for (gf_elt i = 0; i < q; ++i) {
-    printf("  %2u:", i);
-    for (gf_elt j = 0; j < q; ++j) {
-      printf("\t%u", Q[i * q + j]);
-    }
-    printf("\n");
-  }
-#endif
-
-
-  /* V[i * q + j] retourne le j-ème élément du corps fini
-     qui est le plus proche de l'élément i selon la
-     quadrance Q. */ 
-  unsigned *V = malloc(q * q * sizeof *V);
-  for (gf_elt i = 0; i < q; ++i) {
-    /* Alias sur les lignes V[i*q + ...]  et Q[i*q + ...] */
-    unsigned *Vi = V + i * q;
-    unsigned *Qi = Q + i * q;
-    
-    /* Initialisation sur la permutation identité */
-    for (gf_elt j = 0; j < q; ++j) Vi[j] = j;
-    
-    /* On trie Vi sur la quadrance croissante */
-    for (gf_elt j = 0; j < q; ++j)
-      for (gf_elt k = j+1; k < q; ++k)
-        if (Qi[Vi[k]] < Qi[Vi[j]]) {
-          size_t itmp = Vi[j];
-          Vi[j] = Vi[k];
-          Vi[k] = itmp;
-        }
-  }
-
-  unsigned qmin = Q[1];
-  for (size_t i = 1; i < q; ++i)
-    if (qmin > Q[i * q + V[i * q + 1]])
-      qmin = Q[i * q + V[i * q + 1]];
+  struct mapping M;
+  map_init(&M, q, C, pi, qmax);
+  tr_end(TR_MAPPING, t0, -1, 0);
 
 #ifdef DEBUG
-  printf("Voisinage, qmin = %u\n", qmin);
-  for (gf_elt i = 0; i < q; ++i) {
-    printf("  %d:", i);
-    for (gf_elt j = 0; j < q; ++j)
-      printf("\t%d", V[i * q + j]);
-    printf("\n");
-  }
+  map_print(&M);
 #endif
   
   /* Allocation de la mémoire */
   gf_elt *h = malloc(n * sizeof *h); // Parity
   gf_elt *x = malloc(n * sizeof *x); // Mot de code x
   gf_elt *y = malloc(n * sizeof *y); // Voisin y
-  size_t *d = malloc(n * sizeof *d); // Incrément d pour le voisinage
-  size_t *dmax = malloc(n * sizeof *dmax); // Incrément maximal dmax par position
+  struct delta D = {          // Voisins y de x
+    .M = &M, .n = n, .qmax = qmax, .y = y,
+    .d = malloc(n * sizeof *D.d),
+    .acc = malloc((n + 1) * sizeof *D.acc),
+    .nz = malloc((n + 1) * sizeof *D.nz),
+  };
 
   /* ** Mise en place des spectres */
   /* S[i * qmax + j] retourne le spectre de la parité numéro
-     i pour la quadrance j. */
+     hid0 + i du bloc courant pour la quadrance j. */
   size_t nspectra = 0;
   chk_begin(n, h);
   do { nspectra++; } while (chk_next(n, h));
-  unsigned long *S;
-  if (NULL == (S = calloc(nspectra * qmax, sizeof *S)))
-    error("Mémoire insuffisance pour les spectres.");
+  size_t block = mem_budget() / (qmax * sizeof(uint32_t));
+  if (block == 0) error("Le budget mémoire ne contient pas un spectre.");
+  if (block > nspectra) block = nspectra;
+  uint32_t *S = malloc(block * qmax * sizeof *S);
+  if (S == NULL) error("Mémoire insuffisante pour les spectres.");
+  size_t nblocks = (nspectra + block - 1) / block;
+  if (nblocks > 1)
+    printf("blocs: %zu de %zu parités\n", nblocks, block);
+  gf_elt *h0 = malloc(n * sizeof *h0); // Première parité du bloc
+  chk_begin(n, h0);
+  struct overflow *big = NULL;         // Compteurs promus du bloc
+  size_t nbig = 0, bigsize = 0;
+  unsigned *nzq = malloc(qmax * sizeof *nzq); // Ligne creuse
+  unsigned long long *nzm = malloc(qmax * sizeof *nzm);
+
+  /* Format de sortie */
+  const char *env = getenv("BESTPARITY_SPARSE");
+  bool sparse = env != NULL && atoi(env) != 0;
+  FILE *bin = NULL;
+  struct sp_writer W;
+  if (binfile != NULL) {
+    if (NULL == (bin = fopen(binfile, "wb")))
+      error("Impossible d'écrire le fichier de spectres '%s'.", binfile);
+    sp_wopen(&W, bin, n, qmax);
+  }
 
-  
-  /* Pour chaque couple (x, y) en passage par l'incrément d. */
-  cw_begin(n, x);
-  do {
-    /* Calcul de l'incrément maximal */
-    for (size_t i = 0; i < n; ++i) {
-      dmax[i] = q;
-      unsigned *Qxi = Q + x[i] * q;
-      unsigned *Vxi = V + x[i] * q;
-      for (size_t j = 0; j < q; ++j)
-        if (Qxi[Vxi[j]] >= qmax - qmin) {
-          dmax[i] = j;
-          break;
-        }
-    }
-    
-    delta_begin(n, d);
+  ST_ADD(ST_PARITIES, nspectra);
+  unsigned long long rank = 0, nvec = 1;
+  for (size_t i = 0; i < n; ++i) nvec *= q;
+  pg_start("vectors", nvec * nblocks);
+  for (size_t hid0 = 0; hid0 < nspectra; hid0 += block) {
+    const size_t len = nspectra - hid0 < block ? nspectra - hid0 : block;
+    memset(S, 0, len * qmax * sizeof *S);
+    nbig = 0;
+
+    /* Pour chaque couple (x, y) en passage par l'incrément d. */
+    pf_phase(PF_SEARCH);
+    vec_begin(n, x);
     do {
-      /* Calcul de y en fonction de x et de d et la quandrance. */
-      unsigned quad = 0;
-      for (size_t i = 0; i < n; ++i) {
-        y[i] = V[x[i] * q + d[i]];
-        quad += Q[x[i] * q + y[i]];
-      }
+      pg_tick(rank);
+      t0 = tr_begin();
+      ST_ADD(ST_CODEWORDS, 1);
+
+      delta_begin(&D, x);
+      do {
+        /* y et sa quadrance sont tenus par le parcours */
+        ST_ADD(ST_NEIGHBOURS, 1);
+        unsigned quad = D.acc[0];
 
 #ifdef DEBUG
-      printf("  x:");
-      for (size_t i = 0; i < n; ++i) printf(" %2u", x[i]);
-      printf("\ty:");
-      for (size_t i = 0; i < n; ++i) printf(" %2u", y[i]);
-      printf("\t%u\n", quad);
+        printf("  x:");
+        for (size_t i = 0; i < n; ++i) printf(" %2u", x[i]);
+        printf("\ty:");
+        for (size_t i = 0; i < n; ++i) printf(" %2u", y[i]);
+        printf("\t%u\n", quad);
 #endif
 
-      if (quad >= qmax)
-        continue;
-      
-      /* Passe en revue les parités */
-      chk_begin(n, h);
-      size_t hid = 0;
-      do {
-        if (chk_valid(n, h, x) && chk_valid(n, h, y)) {
-          S[hid * qmax + quad]++;
+        /* Passe en revue les parités du bloc */
+        memcpy(h, h0, n * sizeof *h);
+        for (size_t hid = 0; hid < len; ++hid) {
+          ST_ADD(ST_CHECKS, 1);
+          if (chk_valid(n, h, x) && chk_valid(n, h, y)) {
+            ST_ADD(ST_VALID, 1);
+            ST_HIT(quad, 1);
+            if (++S[hid * qmax + quad] == 0) {
+              /* Promotion */
+              size_t k, i = hid * qmax + quad;
+              for (k = 0; k < nbig && big[k].index != i; ++k);
+              if (k == nbig) {
+                if (nbig == bigsize)
+                  big = realloc(big, (bigsize = bigsize ? 2 * bigsize : 16) * sizeof *big);
+                big[nbig++] = (struct overflow) { i, 0 };
+              }
+              big[k].high++;
+            }
 #ifdef DEBUG
-          printf("    h: ");
-          for (size_t i = 0; i < n; ++i)
-            printf(" %u", h[i]);
-          printf("\n");
+            printf("    h: ");
+            for (size_t i = 0; i < n; ++i)
+              printf(" %u", h[i]);
+            printf("\n");
 #endif
+          }
+          chk_next(n, h);
         }
-        hid++;
-      } while (chk_next(n, h));
-    } while (delta_next(n, dmax, d));
-  } while (cw_next(n, x));
+      } while (delta_next(&D));
+      tr_end(TR_VECTOR, t0, rank++, 0);
+    } while (vec_next(n, x));
+
+
+    /* Affichage des résultats du bloc */
+    pf_phase(PF_OUTPUT);
+    t0 = tr_begin();
+    if (hid0 == 0 && bin == NULL) printf("Sectra\n");
+    qsort(big, nbig, sizeof *big, overflow_cmp);
+    memcpy(h, h0, n * sizeof *h);
+    for (size_t hid = 0, b = 0; hid < len; ++hid) {
+      /* Multiplicités non nulles de la ligne */
+      size_t k = 0;
+      for (size_t i = 0; i < qmax; ++i) {
+        unsigned long long v = S[hid * qmax + i];
+        if (b < nbig && big[b].index == hid * qmax + i)
+          v += big[b++].high << 32;
+        if (v == 0) continue;
+        nzq[k] = i;
+        nzm[k++] = v;
+      }
 
+      if (bin != NULL) {
+        if (k > 0) sp_write(&W, hid0 + hid, h, k, nzq, nzm);
+        chk_next(n, h);
+        continue;
+      }
 
-  /* Affichage des résultats */
-  printf("Sectra\n");
-  chk_begin(n, h);
-  size_t hid = 0;
-  do {
-    printf("%4zu:", hid);
-    for (size_t i = 0; i < n; ++i)
-      printf(" %2u", h[i]);
-    printf(":\t");
-
-    unsigned long sum = 0;
-    for (size_t i = 0; i < qmax; ++i) {
-      sum += S[hid * qmax + i];
-      printf("%lu\t", S[hid * qmax + i]);
+      printf("%4zu:", hid0 + hid);
+      for (size_t i = 0; i < n; ++i)
+        printf(" %2u", h[i]);
+      printf(":\t");
+
+      unsigned long long sum = 0;
+      for (size_t i = 0, j = 0; i < qmax; ++i) {
+        unsigned long long v = j < k && nzq[j] == i ? nzm[j++] : 0;
+        sum += v;
+        if (!sparse)
+          printf("%llu\t", v);
+        else if (v > 0)
+          printf("%zu:%llu\t", i, v);
+      }
+      printf("\t(%llu)\n", sum);
+      chk_next(n, h);
     }
-    printf("\t(%lu)\n", sum);
-    hid++;
-  } while (chk_next(n, h));
+    fflush(bin != NULL ? bin : stdout);
+    memcpy(h0, h, n * sizeof *h);
+    tr_end(TR_OUTPUT, t0, -1, 0);
+  }
+  pg_stop();
 
   
   /* Libération des ressources */
-  if (f != stdin) fclose (stdin);
+  if (f != stdin) fclose (f);
+  if (bin != NULL && fclose(bin) != 0)
+    error("Impossible d'écrire le fichier de spectres '%s'.", binfile);
   free(S);
-  free(Q);
+  free(big);
+  free(nzq);
+  free(nzm);
+  free(h0);
+  free(D.d);
+  free(D.acc);
+  free(D.nz);
+  map_free(&M);
   free(C);
   free(pi);
   free(y);
   free(x);
   free(h);
   gf_free();
+  st_report(stderr);
+  pf_report(stderr);
+  tr_stop();
 }
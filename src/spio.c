@@ -0,0 +1,144 @@
+#include <string.h>
+
+#include "bestparity.h"
+
+
+/* * Spectres compressés
+ *
+ * Format binaire des spectres écrits par spectra. Tous les
+ * entiers sont des varints (LEB128 non signés : 7 bits par
+ * octet, bit de poids fort levé s'il en suit un autre).
+ *
+ * - en-tête : les 4 octets « BPSP », puis la version (1), n
+ *   et qmax ;
+ * - puis une ligne par parité de spectre non nul : l'écart
+ *   de rang avec la ligne précédente (le rang lui-même pour
+ *   la première, 0 pour deux rangs consécutifs), les n
+ *   coefficients de h, le nombre k de quadrances de
+ *   multiplicité non nulle, puis k couples (écart de
+ *   quadrance avec la précédente ou 0, multiplicité).
+ *
+ * Le fichier se termine avec la dernière ligne.
+ */
+
+#define SP_MAGIC "BPSP"
+#define SP_VERSION 1
+
+
+static void sp_put(FILE *f, unsigned long long v) {
+  uint8_t b[10];
+  size_t len = 0;
+  do {
+    b[len] = v & 0x7f;
+    v >>= 7;
+    if (v != 0) b[len] |= 0x80;
+    len++;
+  } while (v != 0);
+  fwrite(b, 1, len, f);
+}
+
+
+/* Lit un varint dans *v ; retourne false en fin de fichier
+   avant son premier octet. */
+static bool sp_get(FILE *f, unsigned long long *v) {
+  *v = 0;
+  for (unsigned shift = 0; ; shift += 7) {
+    int c = getc(f);
+    if (c == EOF) {
+      if (shift == 0) return false;
+      error("Fichier de spectres tronqué.");
+    }
+    if (shift > 63) error("Fichier de spectres corrompu.");
+    *v |= (unsigned long long) (c & 0x7f) << shift;
+    if (!(c & 0x80)) return true;
+  }
+}
+
+
+static unsigned long long sp_need(FILE *f) {
+  unsigned long long v;
+  if (!sp_get(f, &v)) error("Fichier de spectres tronqué.");
+  return v;
+}
+
+
+/* ** Écriture */
+
+void sp_wopen(struct sp_writer *W, FILE *f, size_t n, unsigned qmax) {
+  W->f = f;
+  W->n = n;
+  W->next = 0;
+  fwrite(SP_MAGIC, 1, 4, f);
+  sp_put(f, SP_VERSION);
+  sp_put(f, n);
+  sp_put(f, qmax);
+}
+
+
+void sp_write(struct sp_writer *W, unsigned long long rank, const gf_elt *h,
+              size_t k, const unsigned *quad, const unsigned long long *mult) {
+  FILE *f = W->f;
+  sp_put(f, rank - W->next);
+  W->next = rank + 1;
+  for (size_t i = 0; i < W->n; ++i)
+    sp_put(f, h[i]);
+  sp_put(f, k);
+  for (size_t j = 0; j < k; ++j) {
+    sp_put(f, j == 0 ? quad[0] : quad[j] - quad[j-1]);
+    sp_put(f, mult[j]);
+  }
+}
+
+
+/* ** Lecture */
+
+bool sp_ropen(struct sp_reader *R, FILE *f) {
+  char magic[4];
+  if (fread(magic, 1, 4, f) != 4 || memcmp(magic, SP_MAGIC, 4) != 0)
+    return false;
+  if (sp_need(f) != SP_VERSION)
+    error("Version de fichier de spectres inconnue.");
+  R->f = f;
+  R->n = sp_need(f);
+  R->qmax = sp_need(f);
+  R->rank = 0;
+  R->next = 0;
+  R->k = 0;
+  R->h = malloc((R->n + 1) * sizeof *R->h);
+  R->quad = malloc((R->qmax + 1) * sizeof *R->quad);
+  R->mult = malloc((R->qmax + 1) * sizeof *R->mult);
+  if (R->h == NULL || R->quad == NULL || R->mult == NULL)
+    error("Mémoire insuffisante pour lire les spectres.");
+  return true;
+}
+
+
+bool sp_read(struct sp_reader *R) {
+  FILE *f = R->f;
+  unsigned long long v;
+  if (!sp_get(f, &v)) return false;
+  R->rank = R->next + v;
+  R->next = R->rank + 1;
+  for (size_t i = 0; i < R->n; ++i)
+    R->h[i] = sp_need(f);
+  R->k = sp_need(f);
+  if (R->k > R->qmax) error("Fichier de spectres corrompu.");
+  unsigned long long quad = 0;
+  for (size_t j = 0; j < R->k; ++j) {
+    /* Quadrances strictement croissantes, comme à l'écriture */
+    unsigned long long d = sp_need(f);
+    if (j > 0 && d == 0) error("Fichier de spectres corrompu.");
+    quad += d;
+    if (quad >= R->qmax) error("Fichier de spectres corrompu.");
+    R->quad[j] = quad;
+    R->mult[j] = sp_need(f);
+  }
+  return true;
+}
+
+
+void sp_rclose(struct sp_reader *R) {
+  free(R->h);
+  free(R->quad);
+  free(R->mult);
+}
@@ -0,0 +1,56 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bestparity.h"
+
+
+/* * Programme principal
+ *
+ * Relit un fichier de spectres écrit par spectra (cf.
+ * spio.c) et l'affiche en texte : une ligne par parité de
+ * spectre non nul, avec ses couples quadrance:multiplicité,
+ * ou avec -d tout le spectre, colonne par colonne, comme
+ * spectra.
+ */
+
+int main(int argc, char **argv) {
+  bool dense = argc == 3 && strcmp(argv[1], "-d") == 0;
+  if (argc != 2 && !dense) {
+    printf("Usage: %s [-d] spectra.bin\n", argv[0]);
+    return -1;
+  }
+  const char *file = argv[argc - 1];
+
+  FILE *f;
+  if (strcmp(file, "-") == 0)
+    f = stdin;
+  else if (NULL == (f = fopen(file, "rb")))
+    error("Impossible d'ouvrir le fichier de spectres '%s'.", file);
+
+  struct sp_reader R;
+  if (!sp_ropen(&R, f))
+    error("'%s' n'est pas un fichier de spectres.", file);
+  printf("codelength: %zu\n", R.n);
+  printf("qmax: %u\n", R.qmax);
+
+  while (sp_read(&R)) {
+    printf("%4llu:", R.rank);
+    for (size_t i = 0; i < R.n; ++i)
+      printf(" %2u", R.h[i]);
+    printf(":\t");
+
+    unsigned long long sum = 0;
+    for (size_t j = 0, k = 0; dense && j < R.qmax; ++j)
+      printf("%llu\t", k < R.k && R.quad[k] == j ? R.mult[k++] : 0);
+    for (size_t k = 0; k < R.k; ++k) {
+      if (!dense) printf("%u:%llu\t", R.quad[k], R.mult[k]);
+      sum += R.mult[k];
+    }
+    printf("\t(%llu)\n", sum);
+  }
+
+  sp_rclose(&R);
+  if (f != stdin) fclose(f);
+}
@@ -0,0 +1,154 @@
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bestparity.h"
+
+
+/* * Traces
+ *
+ * Les événements sont écrits dans un anneau alloué au
+ * premier d'entre eux. Quand il est plein, les plus anciens
+ * sont écrasés.
+ *
+ * SIGUSR2 ne fait que lever tr_due ; l'export a lieu au
+ * prochain événement ou au prochain tr_poll des boucles sur
+ * les mots de code, hors du gestionnaire.
+ */
+
+#define TR_RING (1 << 16)       /* Événements gardés, puissance de 2 */
+
+static const char *tr_names[TR_KINDS] = {
+  [TR_MAPPING] = "mapping",
+  [TR_TABLES]  = "tables",
+  [TR_PARITY]  = "parity",
+  [TR_VECTOR]  = "vector",
+  [TR_OUTPUT]  = "output",
+};
+
+struct tr_event {
+  uint64_t t0, t1;              /* Début et fin, en ns */
+  long long index;              /* Parité ou vecteur, -1 si sans objet */
+  int mapping;                  /* Mapping, -1 si sans objet */
+  int kind;
+};
+
+struct tr_ring {
+  uint64_t head;                /* Nombre d'événements écrits */
+  struct tr_event ev[TR_RING];
+};
+
+bool tr_enabled;
+volatile sig_atomic_t tr_due;
+
+static const char *tr_path;
+static const char *tr_process;
+static struct tr_ring *tr_ring;
+
+
+uint64_t tr_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+
+static void tr_signal(int sig) {
+  (void) sig;
+  tr_due = 1;
+}
+
+
+void tr_start(const char *process) {
+  tr_path = getenv("BESTPARITY_TRACE");
+  tr_enabled = tr_path != NULL && *tr_path != '\0';
+  if (!tr_enabled) return;
+  tr_process = process;
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof sa);
+  sa.sa_handler = tr_signal;
+  sa.sa_flags = SA_RESTART;
+  sigaction(SIGUSR2, &sa, NULL);
+}
+
+
+void tr_record(int kind, uint64_t t0, long long index, int mapping) {
+  if (tr_ring == NULL) {
+    tr_ring = malloc(sizeof *tr_ring);
+    if (tr_ring == NULL) error("Mémoire insuffisante pour les traces.");
+    tr_ring->head = 0;
+  }
+  struct tr_event *e = &tr_ring->ev[tr_ring->head++ & (TR_RING - 1)];
+  e->t0 = t0;
+  e->t1 = tr_now();
+  e->index = index;
+  e->mapping = mapping;
+  e->kind = kind;
+  tr_poll();
+}
+
+
+/* Écrit s en chaîne JSON, entre guillemets : « " », « \ »
+   et les caractères de contrôle sont échappés. */
+static void tr_string(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; *s; ++s) {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+    else if (c < 0x20) fprintf(f, "\\u%04x", c);
+    else fputc(c, f);
+  }
+  fputc('"', f);
+}
+
+
+/* Format « Trace Event » de Chrome, lisible par
+   chrome://tracing et Perfetto : un événement complet (ph
+   X) par intervalle, temps en microsecondes. */
+void tr_dump(void) {
+  if (!tr_enabled) return;
+
+  FILE *f = fopen(tr_path, "w");
+  if (f == NULL) {
+    fprintf(stderr, "trace: impossible d'écrire '%s'\n", tr_path);
+    return;
+  }
+
+  int pid = getpid();
+  fprintf(f, "{\"traceEvents\":[\n");
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+          "\"args\":{\"name\":", pid);
+  tr_string(f, tr_process);
+  fprintf(f, "}}");
+
+  uint64_t head = tr_ring != NULL ? tr_ring->head : 0;
+  uint64_t first = head > TR_RING ? head - TR_RING : 0;
+  size_t lost = first;
+  for (uint64_t k = first; k < head; ++k) {
+    const struct tr_event *e = &tr_ring->ev[k & (TR_RING - 1)];
+    fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"search\",\"ph\":\"X\","
+            "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":0,\"args\":{",
+            tr_names[e->kind], e->t0 / 1e3, (e->t1 - e->t0) / 1e3, pid);
+    const char *sep = "";
+    if (e->index >= 0) {
+      fprintf(f, "\"%s\":%lld", e->kind == TR_VECTOR ? "vector" : "parity", e->index);
+      sep = ",";
+    }
+    if (e->mapping >= 0)
+      fprintf(f, "%s\"mapping\":%d", sep, e->mapping);
+    fprintf(f, "}}");
+  }
+  fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  fclose(f);
+
+  if (lost > 0)
+    fprintf(stderr, "trace: %zu événements anciens écrasés\n", lost);
+}
+
+
+void tr_stop(void) {
+  tr_dump();
+  tr_enabled = false;
+}
@@ -0,0 +1,79 @@
+#!/bin/bash
+# * Jeu d'entraînement et chronométrage
+#
+# Charges représentatives tirées de data/ pour les cibles
+# pgo et lto du Makefile : 16-QAM et 64-QAM, n = 3 à 5, sur
+# best-parity, spectra et crible. Chaque charge est bornée
+# (quelques secondes) en tronquant la liste des parités
+# criblées ; best-parity et spectra parcourent toutes les
+# parités et ne sont donc pris qu'à n = 3.
+#
+# Usage
+#   ./train.sh                    chronomètre chaque charge
+#                                 (meilleur de REPEAT essais)
+#   ./train.sh run                lance chaque charge une fois
+#                                 (entraînement PGO)
+#   ./train.sh table avant après  tableau comparatif de deux
+#                                 chronométrages
+
+cd "$(dirname "$0")"
+D=${DATA:-../data}
+REPEAT=${REPEAT:-3}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# ** Les charges : nom puis commande
+workloads() {
+  ./combinations 3 64 | head -300 > "$TMP/h3-64"
+  ./combinations 5 16 | head -20 > "$TMP/h5-16"
+  head -100 "$D/H4-16.txt" > "$TMP/h4-16"
+  head -2 "$D/H4-64.txt" > "$TMP/h4-64"
+
+  $1 bp16-n3 ./best-parity 3 0 16 "$D/16-QAM.txt" "$D/16-DVB.txt"
+  $1 sp16-n3 ./spectra 3 6 "$D/16-QAM.txt" "$D/16-DVB.txt"
+  $1 cr16-n4 ./crible 4 4 "$D/16-QAM.txt" "$D/16-DVB.txt" "$TMP/h4-16"
+  $1 cr16-n5 ./crible 5 2 "$D/16-QAM.txt" "$D/16-DVB.txt" "$TMP/h5-16"
+  $1 cr64-n3 ./crible 3 4 "$D/64-QAM.txt" "$D/64-DVB.txt" "$TMP/h3-64"
+  $1 cr64-n4 ./crible 4 4 "$D/64-QAM.txt" "$D/64-DVB.txt" "$TMP/h4-64"
+}
+
+run() {
+  shift
+  "$@" > /dev/null 2>&1 || { echo "échec : $*" >&2; exit 1; }
+}
+
+chrono() {
+  local name=$1 best= t
+  shift
+  TIMEFORMAT=%R
+  for ((k = 0; k < REPEAT; ++k)); do
+    t=$( { time "$@" > /dev/null 2>&1; } 2>&1 ) || { echo "échec : $*" >&2; exit 1; }
+    if [ -z "$best" ] || awk "BEGIN {exit !($t < $best)}"; then best=$t; fi
+  done
+  printf "%s\t%s\n" "$name" "$best"
+}
+
+# ** Tableau avant/après
+table() {
+  awk -F '\t' '
+    NR == FNR { avant[$1] = $2; next }
+    FNR == 1 {
+      printf "| %-8s | %9s | %9s | %7s |\n", "charge", "avant (s)", "après (s)", "gain"
+      printf "|----------+-----------+-----------+---------|\n"
+    }
+    $1 in avant {
+      printf "| %-8s | %9.3f | %9.3f | %6.1f%% |\n", $1, avant[$1], $2, 100 * (avant[$1] - $2) / avant[$1]
+      a += avant[$1]; b += $2
+    }
+    END {
+      printf "|----------+-----------+-----------+---------|\n"
+      printf "| %-8s | %9.3f | %9.3f | %6.1f%% |\n", "total", a, b, 100 * (a - b) / a
+    }' "$1" "$2"
+}
+
+case "$1" in
+  run) workloads run ;;
+  table) table "$2" "$3" ;;
+  "") workloads chrono ;;
+  *) echo "Usage: $0 [run | table avant après]" >&2; exit 1 ;;
+esac